@@ -19,12 +19,33 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 #include "g_local.h"
 
+/*
+==================
+GetChaseViewId
+
+Player ID view of the chase target is the same for all of its
+spectators, compute it once per frame.
+==================
+*/
+static int GetChaseViewId(edict_t *targ)
+{
+    gclient_t *c = targ->client;
+
+    if (c->chasecache.viewid_framenum != level.framenum) {
+        c->chasecache.viewid_framenum = level.framenum;
+        c->chasecache.viewid = G_GetPlayerIdView(targ);
+    }
+
+    return c->chasecache.viewid;
+}
+
 static void SetChaseStats(gclient_t *client)
 {
     edict_t *targ = client->chase_target;
     int playernum = (targ - g_edicts) - 1;
 
     memcpy(client->ps.stats, targ->client->ps.stats, sizeof(client->ps.stats));
+    client->statcache.valid = qfalse;
 
     // layouts are independant in chasecam mode
     client->ps.stats[STAT_LAYOUTS] = 0;
@@ -42,19 +63,35 @@ static void SetChaseStats(gclient_t *client)
     if (client->pers.noviewid) {
         client->ps.stats[STAT_VIEWID] = 0;
     } else if (targ->client->pers.noviewid) {
-        client->ps.stats[STAT_VIEWID] = G_GetPlayerIdView(targ);
+        client->ps.stats[STAT_VIEWID] = GetChaseViewId(targ);
     }
 }
 
-static void UpdateChaseCamHack(gclient_t *client)
+/*
+==================
+GetChaseCamGoal
+
+Camera position is the same for all spectators chasing the target, so it
+is traced once and reused until the target moves or next frame starts.
+==================
+*/
+static void GetChaseCamGoal(edict_t *targ, vec3_t goal)
 {
-    vec3_t o, ownerv, goal;
-    edict_t *ent = client->edict;
-    edict_t *targ = client->chase_target;
+    gclient_t *c = targ->client;
+    vec3_t o, ownerv;
     vec3_t forward, right;
     trace_t trace;
     vec3_t angles;
 
+    if (c->chasecache.cam_framenum == level.framenum &&
+        c->chasecache.onground == !!targ->groundentity &&
+        c->chasecache.viewheight == targ->viewheight &&
+        VectorCompare(c->chasecache.origin, targ->s.origin) &&
+        VectorCompare(c->chasecache.angles, c->v_angle)) {
+        VectorCopy(c->chasecache.goal, goal);
+        return;
+    }
+
     VectorCopy(targ->s.origin, ownerv);
 
     ownerv[2] += targ->viewheight;
@@ -96,6 +133,22 @@ static void UpdateChaseCamHack(gclient_t *client)
         goal[2] += 6;
     }
 
+    c->chasecache.cam_framenum = level.framenum;
+    c->chasecache.onground = !!targ->groundentity;
+    c->chasecache.viewheight = targ->viewheight;
+    VectorCopy(targ->s.origin, c->chasecache.origin);
+    VectorCopy(c->v_angle, c->chasecache.angles);
+    VectorCopy(goal, c->chasecache.goal);
+}
+
+static void UpdateChaseCamHack(gclient_t *client)
+{
+    edict_t *ent = client->edict;
+    edict_t *targ = client->chase_target;
+    vec3_t goal;
+
+    GetChaseCamGoal(targ, goal);
+
     if (targ->deadflag)
         client->ps.pmove.pm_type = PM_DEAD;
     else
@@ -146,6 +199,7 @@ void SetChaseTarget(edict_t *ent, edict_t *targ)
 {
     int i;
 
+    List_Delete(&ent->client->level.chase_entry);
     ent->client->chase_target = targ;
 
     // stop chasecam
@@ -162,6 +216,7 @@ void SetChaseTarget(edict_t *ent, edict_t *targ)
         ClientEndServerFrame(ent);
     } else {
         ent->client->clientNum = (targ - g_edicts) - 1;
+        List_Append(&targ->client->level.chasers, &ent->client->level.chase_entry);
         for (i = 0; i < PCS_TOTAL; i++) {
             G_PrivateString(ent, i, targ->client->level.strings[i]);
         }
@@ -192,6 +247,28 @@ void UpdateChaseTargets(chase_mode_t mode, edict_t *targ)
     }
 }
 
+/*
+==================
+ChaseDisconnect
+
+Removes disconnecting client from its chase target's list
+and moves spectators chasing it to another player.
+==================
+*/
+void ChaseDisconnect(edict_t *ent)
+{
+    gclient_t *c, *next;
+
+    List_Delete(&ent->client->level.chase_entry);
+
+    LIST_FOR_EACH_SAFE(gclient_t, c, next, &ent->client->level.chasers, level.chase_entry) {
+        ChaseNext(c->edict);
+        if (c->chase_target == ent) {
+            SetChaseTarget(c->edict, NULL);
+        }
+    }
+}
+
 void ChaseNext(edict_t *ent)
 {
     int i;
@@ -238,13 +315,12 @@ void ChasePrev(edict_t *ent)
 
 qboolean GetChaseTarget(edict_t *ent, chase_mode_t mode)
 {
-    gclient_t *ranks[MAX_CLIENTS];
     edict_t *other;
     int i;
 
     if (mode == CHASE_LEADER) {
-        if (G_CalcRanks(ranks)) {
-            other = ranks[0]->edict;
+        if (level.numranks) {
+            other = level.ranks[0]->edict;
             goto found;
         }
         goto notfound;
@@ -780,6 +780,32 @@ static size_t build_chat(const char *name, chat_t chat, int start, char *buffer)
     return total;
 }
 
+/*
+==================
+G_AllAcceptChat
+
+Returns qtrue if multicast chat would reach exactly the clients
+that gi.cprintf would print it to. Connecting clients would get
+the multicast, and the engine doesn't filter it by message level.
+==================
+*/
+static qboolean G_AllAcceptChat(void)
+{
+    gclient_t *c;
+    int i;
+
+    for (i = 0, c = game.clients; i < game.maxclients; i++, c++) {
+        if (c->pers.connected == CONN_DISCONNECTED) {
+            continue;
+        }
+        if (!c->edict->inuse || c->pers.msglevel > PRINT_CHAT) {
+            return qfalse;
+        }
+    }
+
+    return qtrue;
+}
+
 /*
 ==================
 Cmd_Say_f
@@ -789,7 +815,8 @@ static void Cmd_Say_f(edict_t *ent, chat_t chat)
 {
     int     i, start;
     edict_t *other;
-    char    text[MAX_CHAT];
+    char    text[MAX_CHAT + 1];
+    size_t  len;
     gclient_t *cl = ent->client;
 
     start = (chat == CHAT_MISC) ? 0 : 1;
@@ -827,21 +854,39 @@ static void Cmd_Say_f(edict_t *ent, chat_t chat)
         return;
     }
 
-    build_chat(cl->pers.netname, chat, start, text);
+    len = build_chat(cl->pers.netname, chat, start, text);
 
     if ((int)dedicated->value)
         gi.cprintf(NULL, PRINT_CHAT, "%s\n", text);
 
+    text[len++] = '\n';
+    text[len] = 0;
+
+    // everyone gets the message, send it at once
+    if (chat != CHAT_TEAM && G_AllAcceptChat()) {
+        gi.WriteByte(svc_print);
+        gi.WriteByte(PRINT_CHAT);
+        gi.WriteString(text);
+        gi.multicast(NULL, MULTICAST_ALL_R);
+        return;
+    }
+
+    // otherwise replay the same message to each recipient
     for (i = 1; i <= game.maxclients; i++) {
         other = &g_edicts[i];
         if (!other->inuse)
             continue;
         if (!other->client)
             continue;
+        if (other->client->pers.msglevel > PRINT_CHAT)
+            continue;
         if (chat == CHAT_TEAM && PLAYER_SPAWNED(ent) != PLAYER_SPAWNED(other)) {
             continue;
         }
-        gi.cprintf(other, PRINT_CHAT, "%s\n", text);
+        gi.WriteByte(svc_print);
+        gi.WriteByte(PRINT_CHAT);
+        gi.WriteString(text);
+        gi.unicast(other, qtrue);
     }
 }
 
@@ -1202,6 +1247,80 @@ void Cmd_Stats_f(edict_t *ent, qboolean check_other)
                other->client->resp.damage_recvd);
 }
 
+#if USE_SQLITE
+void G_PrintLifeStats(edict_t *ent, const char *name, const lifestats_t *ls)
+{
+    int i, total;
+    const fragstat_t *s;
+    char acc[16];
+    char hits[32];
+
+    gi.cprintf(ent, PRINT_HIGH,
+               "Lifetime stats for %s:\n"
+               "Weapon     Acc%% Hits/Atts         Frgs  Dths\n"
+               "---------- ---- ----------------- ----- -----\n",
+               name);
+
+    for (i = FRAG_BLASTER; i <= FRAG_BFG; i++) {
+        s = &ls->frags[i];
+        if (!s->atts && !s->kills && !s->deaths) {
+            continue;
+        }
+        if (s->atts && i != FRAG_BFG) {
+            sprintf(acc, "%3i%%", (int)((int64_t)s->hits * 100 / s->atts));
+            sprintf(hits, "%8d/%-8d", s->hits, s->atts);
+        } else {
+            strcpy(acc, "    ");
+            strcpy(hits, "                 ");
+        }
+        gi.cprintf(ent, PRINT_HIGH, "%-10s %s %s %5d %5d\n",
+                   weapnames[i], acc, hits, s->kills, s->deaths);
+    }
+
+    total = ls->score + ls->deaths;
+    gi.cprintf(ent, PRINT_HIGH,
+               "Frags/deaths: %d/%d (K/D %.2f, eff %d%%)\n"
+               "Time played: %d:%02d in %d session%s\n"
+               "Total damage given/recvd: %d/%d\n",
+               ls->score, ls->deaths,
+               ls->deaths ? (float)ls->score / ls->deaths : (float)ls->score,
+               total > 0 && ls->score > 0 ? ls->score * 100 / total : 0,
+               ls->time / 3600, ls->time / 60 % 60,
+               ls->sessions, ls->sessions == 1 ? "" : "s",
+               ls->damage_given, ls->damage_recvd);
+}
+#endif
+
+/*
+==================
+Cmd_LifeStats_f
+
+Lifetime stats are looked up asynchronously,
+the answer is printed on a later frame.
+==================
+*/
+static void Cmd_LifeStats_f(edict_t *ent)
+{
+#if USE_SQLITE
+    edict_t *other;
+
+    if (gi.argc() > 1) {
+        other = G_SetPlayer(ent, 1);
+        if (!other) {
+            return;
+        }
+    } else if (ent->client->chase_target) {
+        other = ent->client->chase_target;
+    } else {
+        other = ent;
+    }
+
+    G_QueryLifeStats(ent, other->client->pers.netname);
+#else
+    gi.cprintf(ent, PRINT_HIGH, "Lifetime stats are not available on this server.\n");
+#endif
+}
+
 static void Cmd_Id_f(edict_t *ent)
 {
     ent->client->pers.noviewid ^= 1;
@@ -1302,6 +1421,7 @@ static void Cmd_Admin_f(edict_t *ent)
         gi.bprintf(PRINT_HIGH, "%s is no longer an admin.\n",
                    ent->client->pers.netname);
         ent->client->pers.admin = qfalse;
+        G_UpdateVoter(ent->client);
         return;
     }
     if (gi.argc() < 2) {
@@ -1322,6 +1442,7 @@ static void Cmd_Admin_f(edict_t *ent)
     gi.bprintf(PRINT_HIGH, "%s became an admin.\n",
                ent->client->pers.netname);
 
+    G_UpdateVoter(ent->client);
     G_CheckVote();
 }
 
@@ -1384,35 +1505,6 @@ static void Cmd_Kick_f(edict_t *ent, qboolean ban)
     }
 }
 
-static void Cmd_AdminCommands_f(edict_t *ent)
-{
-    gi.cprintf(ent, PRINT_HIGH,
-               "(un)mute    Allow/disallow specific player to talk\n"
-               "(un)muteall Allow/disallow everyone to talk\n"
-               "(un)ban     Add/remove temporary bans\n"
-               "bans        List bans\n"
-               "kick        Kick a player\n"
-               "kickban     Kick a player and ban him for 1 hour\n"
-              );
-}
-
-static void Cmd_Commands_f(edict_t *ent)
-{
-    gi.cprintf(ent, PRINT_HIGH,
-               "menu       Show OpenFFA menu\n"
-               "join       Enter the game\n"
-               "observe    Leave the game\n"
-               "chase      Enter chasecam mode\n"
-               "settings   Show match settings\n"
-               "oldscore   Show previous scoreboard\n"
-               "vote       Propose new settings\n"
-               "stats      Show accuracy stats\n"
-               "players    Show players on server\n"
-               "highscores Show the best results on map\n"
-               "id         Toggle player ID display\n"
-              );
-}
-
 static qboolean become_spectator(edict_t *ent)
 {
     switch (ent->client->pers.connected) {
@@ -1568,6 +1660,7 @@ static void Cmd_OldScore_f(edict_t *ent)
     }
 
     ent->client->layout = LAYOUT_OLDSCORES;
+    ent->client->level.scoreboard = 0;
 
     gi.WriteByte(svc_layout);
     gi.WriteString(game.oldscores);
@@ -1575,172 +1668,403 @@ static void Cmd_OldScore_f(edict_t *ent)
 }
 
 /*
-=================
-ClientCommand
-=================
+======================================================================
+
+COMMAND TABLE
+
+======================================================================
 */
-void ClientCommand(edict_t *ent)
-{
-    char    *cmd;
 
-    if (!ent->client)
-        return;     // not fully in game yet
+#define CMD_ADMIN           1   // only for admins, chat for others
+#define CMD_INTERMISSION    2   // allowed during intermission
+#define CMD_VOTE            4   // only while vote is in progress, chat otherwise
+
+// rate limiter tokens taken by command, gameplay commands are free
+#define COST_LIGHT          1
+#define COST_HEAVY          5   // formats lots of output
+
+typedef struct {
+    const char  *name;
+    const char  *aliases;       // space separated
+    void        (*func)(edict_t *);
+    int         flags;
+    int         cost;
+    const char  *help;          // listed by 'commands' or 'acommands'
+    unsigned    count;          // number of times invoked
+    unsigned    rejected;       // number of times rate limited
+} cmd_t;
+
+static void Cmd_Commands_f(edict_t *ent);
+static void Cmd_AdminCommands_f(edict_t *ent);
+
+static void Cmd_SayAll_f(edict_t *ent) { Cmd_Say_f(ent, CHAT_ALL); }
+static void Cmd_SayTeam_f(edict_t *ent) { Cmd_Say_f(ent, CHAT_TEAM); }
+static void Cmd_Accuracy_f(edict_t *ent) { Cmd_Stats_f(ent, qtrue); }
+static void Cmd_Unmute_f(edict_t *ent) { Cmd_Mute_f(ent, qfalse); }
+static void Cmd_MuteOn_f(edict_t *ent) { Cmd_Mute_f(ent, qtrue); }
+static void Cmd_UnmuteAll_f(edict_t *ent) { Cmd_MuteAll_f(ent, qfalse); }
+static void Cmd_MuteAllOn_f(edict_t *ent) { Cmd_MuteAll_f(ent, qtrue); }
+static void Cmd_KickOnly_f(edict_t *ent) { Cmd_Kick_f(ent, qfalse); }
+static void Cmd_KickBan_f(edict_t *ent) { Cmd_Kick_f(ent, qtrue); }
+static void Cmd_InvNext_f(edict_t *ent) { SelectNextItem(ent, -1); }
+static void Cmd_InvPrev_f(edict_t *ent) { SelectPrevItem(ent, -1); }
+static void Cmd_InvNextW_f(edict_t *ent) { SelectNextItem(ent, IT_WEAPON); }
+static void Cmd_InvPrevW_f(edict_t *ent) { SelectPrevItem(ent, IT_WEAPON); }
+static void Cmd_InvNextP_f(edict_t *ent) { SelectNextItem(ent, IT_POWERUP); }
+static void Cmd_InvPrevP_f(edict_t *ent) { SelectPrevItem(ent, IT_POWERUP); }
+static void Cmd_Yes_f(edict_t *ent) { Cmd_CastVote_f(ent, qtrue); }
+static void Cmd_No_f(edict_t *ent) { Cmd_CastVote_f(ent, qfalse); }
+static void Cmd_SayMisc_f(edict_t *ent) { Cmd_Say_f(ent, CHAT_MISC); }
+
+static cmd_t g_commands[] = {
+    // admin commands
+    { "mute", NULL, Cmd_MuteOn_f, CMD_ADMIN | CMD_INTERMISSION, 0,
+      "Disallow specific player to talk" },
+    { "unmute", NULL, Cmd_Unmute_f, CMD_ADMIN | CMD_INTERMISSION, 0,
+      "Allow specific player to talk" },
+    { "muteall", NULL, Cmd_MuteAllOn_f, CMD_ADMIN | CMD_INTERMISSION, 0,
+      "Disallow everyone to talk" },
+    { "unmuteall", NULL, Cmd_UnmuteAll_f, CMD_ADMIN | CMD_INTERMISSION, 0,
+      "Allow everyone to talk" },
+    { "ban", NULL, G_AddIP_f, CMD_ADMIN | CMD_INTERMISSION, 0,
+      "Add temporary ban" },
+    { "unban", NULL, G_RemoveIP_f, CMD_ADMIN | CMD_INTERMISSION, 0,
+      "Remove temporary ban" },
+    { "bans", NULL, G_ListIP_f, CMD_ADMIN | CMD_INTERMISSION, 0,
+      "List bans" },
+    { "kick", "boot", Cmd_KickOnly_f, CMD_ADMIN | CMD_INTERMISSION, 0,
+      "Kick a player" },
+    { "kickban", NULL, Cmd_KickBan_f, CMD_ADMIN | CMD_INTERMISSION, 0,
+      "Kick a player and ban him for 1 hour" },
+    { "acommands", NULL, Cmd_AdminCommands_f, CMD_ADMIN | CMD_INTERMISSION },
+
+    // commands listed by 'commands'
+    { "menu", NULL, Cmd_Menu_f, 0, COST_LIGHT,
+      "Show OpenFFA menu" },
+    { "join", NULL, Cmd_Join_f, 0, COST_LIGHT,
+      "Enter the game" },
+    { "observe", "spectate spec obs observer spectator", Cmd_Observe_f, 0, COST_LIGHT,
+      "Leave the game" },
+    { "chase", NULL, Cmd_Chase_f, 0, COST_LIGHT,
+      "Enter chasecam mode" },
+    { "settings", "matchinfo", Cmd_Settings_f, CMD_INTERMISSION, COST_HEAVY,
+      "Show match settings" },
+    { "oldscore", "oldscores lastscore lastscores", Cmd_OldScore_f, 0, COST_LIGHT,
+      "Show previous scoreboard" },
+    { "vote", "callvote", Cmd_Vote_f, 0, COST_HEAVY,
+      "Propose new settings" },
+    { "stats", "accuracy", Cmd_Accuracy_f, CMD_INTERMISSION, COST_HEAVY,
+      "Show accuracy stats" },
+    { "lifestats", NULL, Cmd_LifeStats_f, CMD_INTERMISSION, COST_HEAVY,
+      "Show lifetime stats" },
+    { "players", "playerlist", Cmd_Players_f, CMD_INTERMISSION, COST_HEAVY,
+      "Show players on server" },
+    { "highscores", "highscore", Cmd_HighScores_f, CMD_INTERMISSION, COST_HEAVY,
+      "Show the best results on map" },
+    { "id", NULL, Cmd_Id_f, CMD_INTERMISSION, COST_LIGHT,
+      "Toggle player ID display" },
+
+    // other commands
+    { "say", NULL, Cmd_SayAll_f, CMD_INTERMISSION, COST_LIGHT },
+    { "say_team", NULL, Cmd_SayTeam_f, CMD_INTERMISSION, COST_LIGHT },
+    { "admin", "referee", Cmd_Admin_f, CMD_INTERMISSION, COST_LIGHT },
+    { "commands", NULL, Cmd_Commands_f, CMD_INTERMISSION, COST_LIGHT },
+    { "score", "help", Cmd_Score_f, 0, COST_LIGHT },
+    { "use", NULL, Cmd_Use_f },
+    { "drop", NULL, Cmd_Drop_f, 0, COST_LIGHT },
+    { "give", NULL, Cmd_Give_f },
+    { "god", NULL, Cmd_God_f },
+    { "notarget", NULL, Cmd_Notarget_f },
+    { "noclip", NULL, Cmd_Noclip_f },
+    { "inven", NULL, Cmd_Inven_f },
+    { "invnext", NULL, Cmd_InvNext_f },
+    { "invprev", NULL, Cmd_InvPrev_f },
+    { "invnextw", NULL, Cmd_InvNextW_f },
+    { "invprevw", NULL, Cmd_InvPrevW_f },
+    { "invnextp", NULL, Cmd_InvNextP_f },
+    { "invprevp", NULL, Cmd_InvPrevP_f },
+    { "invuse", NULL, Cmd_InvUse_f },
+    { "invdrop", NULL, Cmd_InvDrop_f },
+    { "weapprev", NULL, Cmd_WeapPrev_f },
+    { "weapnext", NULL, Cmd_WeapNext_f },
+    { "weaplast", NULL, Cmd_WeapLast_f },
+    { "kill", NULL, Cmd_Kill_f },
+    { "putaway", NULL, Cmd_PutAway_f },
+    { "wave", NULL, Cmd_Wave_f, 0, COST_LIGHT },
+    { "yes", NULL, Cmd_Yes_f, CMD_VOTE, COST_LIGHT },
+    { "no", NULL, Cmd_No_f, CMD_VOTE, COST_LIGHT },
+};
 
-    if (ent->client->pers.connected <= CONN_CONNECTED) {
-        return;
+// anything that doesn't match a command will be a chat
+static cmd_t g_chat = { "(chat)", NULL, Cmd_SayMisc_f, 0, COST_LIGHT };
+
+#define CMD_HASH_SIZE   64
+#define MAX_CMD_NAMES   128
+
+typedef struct cmdname_s {
+    const char          *name;  // not terminated for aliases
+    size_t              len;
+    cmd_t               *cmd;
+    struct cmdname_s    *next;
+} cmdname_t;
+
+static cmdname_t    *cmd_hash[CMD_HASH_SIZE];
+static cmdname_t    cmd_names[MAX_CMD_NAMES];
+static int          cmd_numnames;
+
+static void AddCommandName(cmd_t *cmd, const char *name, size_t len)
+{
+    cmdname_t *n;
+    unsigned hash;
+
+    if (cmd_numnames == MAX_CMD_NAMES) {
+        gi.error("%s: too many command names", __func__);
     }
 
-    //ent->client->resp.activity_framenum = level.framenum;
+    n = &cmd_names[cmd_numnames++];
+    n->name = name;
+    n->len = len;
+    n->cmd = cmd;
 
-    cmd = gi.argv(0);
+    hash = G_HashString(name, len, CMD_HASH_SIZE);
+    n->next = cmd_hash[hash];
+    cmd_hash[hash] = n;
+}
 
-    if (ent->client->pers.admin) {
-        if (Q_stricmp(cmd, "mute") == 0) {
-            Cmd_Mute_f(ent, qtrue);
-            return;
-        }
-        if (Q_stricmp(cmd, "unmute") == 0) {
-            Cmd_Mute_f(ent, qfalse);
-            return;
-        }
-        if (Q_stricmp(cmd, "muteall") == 0) {
-            Cmd_MuteAll_f(ent, qtrue);
-            return;
+static void InitCommands(void)
+{
+    cmd_t *cmd;
+    const char *s, *p;
+
+    for (cmd = g_commands; cmd < g_commands + q_countof(g_commands); cmd++) {
+        AddCommandName(cmd, cmd->name, strlen(cmd->name));
+        for (s = cmd->aliases; s && *s; s = p) {
+            p = strchr(s, ' ');
+            if (!p) {
+                p = s + strlen(s);
+            }
+            AddCommandName(cmd, s, p - s);
+            while (*p == ' ') {
+                p++;
+            }
         }
-        if (Q_stricmp(cmd, "unmuteall") == 0) {
-            Cmd_MuteAll_f(ent, qfalse);
-            return;
+    }
+}
+
+static cmd_t *FindCommand(const char *name)
+{
+    cmdname_t *n;
+    size_t len;
+
+    if (!cmd_numnames) {
+        InitCommands();
+    }
+
+    len = strlen(name);
+    for (n = cmd_hash[G_HashString(name, len, CMD_HASH_SIZE)]; n; n = n->next) {
+        if (n->len == len && !Q_strncasecmp(n->name, name, len)) {
+            return n->cmd;
         }
-        if (Q_stricmp(cmd, "ban") == 0) {
-            G_AddIP_f(ent);
-            return;
+    }
+
+    return NULL;
+}
+
+static void ListCommands(edict_t *ent, int flags)
+{
+    cmd_t *cmd;
+
+    for (cmd = g_commands; cmd < g_commands + q_countof(g_commands); cmd++) {
+        if (cmd->help && (cmd->flags & CMD_ADMIN) == flags) {
+            gi.cprintf(ent, PRINT_HIGH, "%-10s %s\n", cmd->name, cmd->help);
         }
-        if (Q_stricmp(cmd, "unban") == 0) {
-            G_RemoveIP_f(ent);
-            return;
+    }
+}
+
+static void Cmd_AdminCommands_f(edict_t *ent)
+{
+    ListCommands(ent, CMD_ADMIN);
+}
+
+static void Cmd_Commands_f(edict_t *ent)
+{
+    ListCommands(ent, 0);
+}
+
+/*
+======================================================================
+
+RATE LIMITING
+
+Each client command takes tokens from two buckets: one owned by the
+client and one shared by all clients connecting from the same address.
+Buckets refill continuously up to their burst size.
+
+======================================================================
+*/
+
+static void RefillTokens(ratelimit_t *r, float rate, float burst)
+{
+    if (!r->framenum || r->framenum > level.framenum) {
+        // never used or level restarted
+        r->tokens = burst;
+    } else {
+        r->tokens += (level.framenum - r->framenum) * rate / HZ;
+        if (r->tokens > burst) {
+            r->tokens = burst;
         }
-        if (Q_stricmp(cmd, "bans") == 0) {
-            G_ListIP_f(ent);
-            return;
+    }
+    r->framenum = level.framenum;
+}
+
+static ratelimit_t *AddressLimit(const char *ip)
+{
+    char address[sizeof(game.addrlimits[0].address)];
+    addrlimit_t *a, *unused = NULL;
+    ratelimit_t tmp;
+    char *p;
+    int i;
+
+    Q_strlcpy(address, ip, sizeof(address));
+    if ((p = strrchr(address, ':')) != NULL) {
+        *p = 0;
+    }
+
+    for (i = 0, a = game.addrlimits; i < game.maxclients; i++, a++) {
+        if (!strcmp(a->address, address)) {
+            return &a->limit;
         }
-        if (Q_stricmp(cmd, "kick") == 0 || Q_stricmp(cmd, "boot") == 0) {
-            Cmd_Kick_f(ent, qfalse);
-            return;
+        if (unused) {
+            continue;
         }
-        if (Q_stricmp(cmd, "kickban") == 0) {
-            Cmd_Kick_f(ent, qtrue);
-            return;
+        if (!a->address[0]) {
+            unused = a;
+            continue;
         }
-        if (Q_stricmp(cmd, "acommands") == 0) {
-            Cmd_AdminCommands_f(ent);
-            return;
+        // entries with full bucket hold no state and can be reused
+        tmp = a->limit;
+        RefillTokens(&tmp, flood_addrrate->value, flood_addrburst->value);
+        if (tmp.tokens >= flood_addrburst->value) {
+            unused = a;
         }
     }
 
-    if (Q_stricmp(cmd, "say") == 0) {
-        Cmd_Say_f(ent, CHAT_ALL);
-        return;
+    if (!unused) {
+        return NULL;
     }
-    if (Q_stricmp(cmd, "say_team") == 0) {
-        Cmd_Say_f(ent, CHAT_TEAM);
-        return;
+
+    strcpy(unused->address, address);
+    unused->limit.framenum = 0;
+    return &unused->limit;
+}
+
+/*
+=================
+G_RateLimit
+
+Returns qtrue if client is sending commands too fast.
+=================
+*/
+static qboolean G_RateLimit(edict_t *ent, int cost)
+{
+    gclient_t *client = ent->client;
+    ratelimit_t *c = NULL, *a = NULL;
+
+    if (cost <= 0 || client->pers.admin) {
+        return qfalse;
     }
-    if (Q_stricmp(cmd, "players") == 0 || Q_stricmp(cmd, "playerlist") == 0) {
-        Cmd_Players_f(ent);
-        return;
+
+    if (flood_cmdrate->value > 0) {
+        c = &client->level.cmd_limit;
+        RefillTokens(c, flood_cmdrate->value, flood_cmdburst->value);
+        if (c->tokens < cost) {
+            goto limited;
+        }
     }
-    if (Q_stricmp(cmd, "highscore") == 0 || Q_stricmp(cmd, "highscores") == 0) {
-        Cmd_HighScores_f(ent);
-        return;
+
+    if (flood_addrrate->value > 0 && (a = AddressLimit(client->pers.ip)) != NULL) {
+        RefillTokens(a, flood_addrrate->value, flood_addrburst->value);
+        if (a->tokens < cost) {
+            goto limited;
+        }
+        a->tokens -= cost;
     }
-    if (Q_stricmp(cmd, "stats") == 0 || Q_stricmp(cmd, "accuracy") == 0) {
-        Cmd_Stats_f(ent, qtrue);
-        return;
+
+    if (c) {
+        c->tokens -= cost;
     }
-    if (Q_stricmp(cmd, "settings") == 0 || Q_stricmp(cmd, "matchinfo") == 0) {
-        Cmd_Settings_f(ent);
-        return;
+    return qfalse;
+
+limited:
+    gi.cprintf(ent, PRINT_HIGH, "You are sending commands too fast.\n");
+    return qtrue;
+}
+
+/*
+=================
+G_CommandStats_f
+
+Prints how many times each client command was invoked
+and rejected by rate limiter.
+=================
+*/
+void G_CommandStats_f(void)
+{
+    cmd_t *cmd;
+
+    Com_Printf("Calls      Rejected   Command\n"
+               "---------- ---------- ----------\n");
+    for (cmd = g_commands; cmd < g_commands + q_countof(g_commands); cmd++) {
+        if (cmd->count || cmd->rejected) {
+            Com_Printf("%10u %10u %s\n", cmd->count, cmd->rejected, cmd->name);
+        }
     }
-    if (Q_stricmp(cmd, "admin") == 0 || Q_stricmp(cmd, "referee") == 0) {
-        Cmd_Admin_f(ent);
-        return;
+    cmd = &g_chat;
+    if (cmd->count || cmd->rejected) {
+        Com_Printf("%10u %10u %s\n", cmd->count, cmd->rejected, cmd->name);
     }
-    if (Q_stricmp(cmd, "commands") == 0) {
-        Cmd_Commands_f(ent);
+}
+
+/*
+=================
+ClientCommand
+=================
+*/
+void ClientCommand(edict_t *ent)
+{
+    cmd_t   *cmd;
+
+    if (!ent->client)
+        return;     // not fully in game yet
+
+    if (ent->client->pers.connected <= CONN_CONNECTED) {
         return;
     }
-    if (Q_stricmp(cmd, "id") == 0) {
-        Cmd_Id_f(ent);
+
+    //ent->client->resp.activity_framenum = level.framenum;
+
+    cmd = FindCommand(gi.argv(0));
+
+    // commands not available to this client are chat
+    if (cmd && (cmd->flags & CMD_ADMIN) && !ent->client->pers.admin) {
+        cmd = NULL;
+    }
+    if (cmd && (cmd->flags & CMD_VOTE) && !level.vote.proposal) {
+        cmd = NULL;
+    }
+
+    if (level.intermission_framenum && !(cmd && (cmd->flags & CMD_INTERMISSION)))
         return;
+
+    if (!cmd) {
+        cmd = &g_chat;
     }
 
-    if (level.intermission_framenum)
+    if (G_RateLimit(ent, cmd->cost)) {
+        cmd->rejected++;
         return;
+    }
 
-    if (Q_stricmp(cmd, "score") == 0 || Q_stricmp(cmd, "help") == 0)
-        Cmd_Score_f(ent);
-    else if (Q_stricmp(cmd, "oldscore") == 0 || Q_stricmp(cmd, "oldscores") == 0 ||
-             Q_stricmp(cmd, "lastscore") == 0 || Q_stricmp(cmd, "lastscores") == 0)
-        Cmd_OldScore_f(ent);
-    else if (Q_stricmp(cmd, "use") == 0)
-        Cmd_Use_f(ent);
-    else if (Q_stricmp(cmd, "drop") == 0)
-        Cmd_Drop_f(ent);
-    else if (Q_stricmp(cmd, "give") == 0)
-        Cmd_Give_f(ent);
-    else if (Q_stricmp(cmd, "god") == 0)
-        Cmd_God_f(ent);
-    else if (Q_stricmp(cmd, "notarget") == 0)
-        Cmd_Notarget_f(ent);
-    else if (Q_stricmp(cmd, "noclip") == 0)
-        Cmd_Noclip_f(ent);
-    else if (Q_stricmp(cmd, "inven") == 0)
-        Cmd_Inven_f(ent);
-    else if (Q_stricmp(cmd, "invnext") == 0)
-        SelectNextItem(ent, -1);
-    else if (Q_stricmp(cmd, "invprev") == 0)
-        SelectPrevItem(ent, -1);
-    else if (Q_stricmp(cmd, "invnextw") == 0)
-        SelectNextItem(ent, IT_WEAPON);
-    else if (Q_stricmp(cmd, "invprevw") == 0)
-        SelectPrevItem(ent, IT_WEAPON);
-    else if (Q_stricmp(cmd, "invnextp") == 0)
-        SelectNextItem(ent, IT_POWERUP);
-    else if (Q_stricmp(cmd, "invprevp") == 0)
-        SelectPrevItem(ent, IT_POWERUP);
-    else if (Q_stricmp(cmd, "invuse") == 0)
-        Cmd_InvUse_f(ent);
-    else if (Q_stricmp(cmd, "invdrop") == 0)
-        Cmd_InvDrop_f(ent);
-    else if (Q_stricmp(cmd, "weapprev") == 0)
-        Cmd_WeapPrev_f(ent);
-    else if (Q_stricmp(cmd, "weapnext") == 0)
-        Cmd_WeapNext_f(ent);
-    else if (Q_stricmp(cmd, "weaplast") == 0)
-        Cmd_WeapLast_f(ent);
-    else if (Q_stricmp(cmd, "kill") == 0)
-        Cmd_Kill_f(ent);
-    else if (Q_stricmp(cmd, "putaway") == 0)
-        Cmd_PutAway_f(ent);
-    else if (Q_stricmp(cmd, "wave") == 0)
-        Cmd_Wave_f(ent);
-    else if (Q_stricmp(cmd, "observe") == 0 || Q_stricmp(cmd, "spectate") == 0 ||
-             Q_stricmp(cmd, "spec") == 0 || Q_stricmp(cmd, "obs") == 0 ||
-             Q_stricmp(cmd, "observer") == 0 || Q_stricmp(cmd, "spectator") == 0)
-        Cmd_Observe_f(ent);
-    else if (Q_stricmp(cmd, "chase") == 0)
-        Cmd_Chase_f(ent);
-    else if (Q_stricmp(cmd, "join") == 0)
-        Cmd_Join_f(ent);
-    else if (Q_stricmp(cmd, "vote") == 0 || Q_stricmp(cmd, "callvote") == 0)
-        Cmd_Vote_f(ent);
-    else if (Q_stricmp(cmd, "yes") == 0 && level.vote.proposal)
-        Cmd_CastVote_f(ent, qtrue);
-    else if (Q_stricmp(cmd, "no") == 0 && level.vote.proposal)
-        Cmd_CastVote_f(ent, qfalse);
-    else if (Q_stricmp(cmd, "menu") == 0)
-        Cmd_Menu_f(ent);
-    else    // anything that doesn't match a command will be a chat
-        Cmd_Say_f(ent, CHAT_MISC);
+    cmd->count++;
+    cmd->func(ent);
 }
-
@@ -31,15 +31,16 @@ explosions and melee attacks.
 */
 qboolean CanDamage(edict_t *targ, edict_t *inflictor)
 {
+    vec_t   *org = inflictor->s.origin;
     vec3_t  dest;
     trace_t trace;
-    int i;
+    int i, nearest;
 
 // bmodels need special checking because their origin is 0,0,0
     if (targ->movetype == MOVETYPE_PUSH) {
         VectorAdd(targ->absmin, targ->absmax, dest);
         VectorScale(dest, 0.5, dest);
-        trace = gi.trace(inflictor->s.origin, vec3_origin, vec3_origin, dest, inflictor, MASK_SOLID);
+        trace = gi.trace(org, vec3_origin, vec3_origin, dest, inflictor, MASK_SOLID);
         if (trace.fraction == 1.0)
             return qtrue;
         if (trace.ent == targ)
@@ -47,37 +48,45 @@ qboolean CanDamage(edict_t *targ, edict_t *inflictor)
         return qfalse;
     }
 
-    trace = gi.trace(inflictor->s.origin, vec3_origin, vec3_origin, targ->s.origin, inflictor, MASK_SOLID);
+    trace = gi.trace(org, vec3_origin, vec3_origin, targ->s.origin, inflictor, MASK_SOLID);
     if (trace.fraction == 1.0)
         return qtrue;
 
+    // test corners closest to inflictor first, they are most likely visible
     if ((int)g_bugs->value < 1) {
         vec_t *bounds[] = { targ->absmin, targ->absmax };
 
+        nearest = (org[0] > targ->s.origin[0]) << 0 |
+               (org[1] > targ->s.origin[1]) << 1 |
+               (org[2] > targ->s.origin[2]) << 2;
+
         for (i = 0; i < 8; i++) {
-            dest[0] = bounds[(i >> 0) & 1][0];
-            dest[1] = bounds[(i >> 1) & 1][1];
-            dest[2] = bounds[(i >> 2) & 1][2];
+            dest[0] = bounds[((i ^ nearest) >> 0) & 1][0];
+            dest[1] = bounds[((i ^ nearest) >> 1) & 1][1];
+            dest[2] = bounds[((i ^ nearest) >> 2) & 1][2];
 
-            trace = gi.trace(inflictor->s.origin, vec3_origin, vec3_origin, dest, inflictor, MASK_SOLID);
+            trace = gi.trace(org, vec3_origin, vec3_origin, dest, inflictor, MASK_SOLID);
             if (trace.fraction == 1.0)
                 return qtrue;
         }
     } else {
+        nearest = (org[0] < targ->s.origin[0]) << 0 |
+               (org[1] < targ->s.origin[1]) << 1;
+
         dest[2] = targ->s.origin[2];
         for (i = 0; i < 4; i++) {
-            if (i & 1) {
+            if ((i ^ nearest) & 1) {
                 dest[0] = targ->s.origin[0] - 15.0f;
             } else {
                 dest[0] = targ->s.origin[0] + 15.0f;
             }
-            if (i & 2) {
+            if ((i ^ nearest) & 2) {
                 dest[1] = targ->s.origin[1] - 15.0f;
             } else {
                 dest[1] = targ->s.origin[1] + 15.0f;
             }
 
-            trace = gi.trace(inflictor->s.origin, vec3_origin, vec3_origin, dest, inflictor, MASK_SOLID);
+            trace = gi.trace(org, vec3_origin, vec3_origin, dest, inflictor, MASK_SOLID);
             if (trace.fraction == 1.0)
                 return qtrue;
         }
@@ -105,9 +114,26 @@ static void Killed(edict_t *targ, edict_t *inflictor, edict_t *attacker, int dam
 /*
 ================
 SpawnDamage
+
+Damage effects are accumulated per target and effect type and sent once
+per frame from the average position, instead of one per hit.
 ================
 */
-static void SpawnDamage(int type, vec3_t origin, vec3_t normal)
+#define MAX_DAMAGE_EFFECTS  64
+
+typedef struct {
+    edict_t     *targ;
+    int         type;
+    int         count;
+    vec3_t      origin;     // sum of all origins
+    vec3_t      normal;     // sum of all normals
+    vec3_t      first;      // normal of the first hit
+} damagefx_t;
+
+static damagefx_t   damage_effects[MAX_DAMAGE_EFFECTS];
+static int          num_damage_effects;
+
+static void WriteDamage(int type, vec3_t origin, vec3_t normal)
 {
     gi.WriteByte(svc_temp_entity);
     gi.WriteByte(type);
@@ -116,6 +142,72 @@ static void SpawnDamage(int type, vec3_t origin, vec3_t normal)
     gi.multicast(origin, MULTICAST_PVS);
 }
 
+static void SpawnDamage(edict_t *targ, int type, vec3_t origin, vec3_t normal)
+{
+    damagefx_t *fx;
+    int i;
+
+    for (i = 0, fx = damage_effects; i < num_damage_effects; i++, fx++) {
+        if (fx->targ == targ && fx->type == type) {
+            VectorAdd(fx->origin, origin, fx->origin);
+            VectorAdd(fx->normal, normal, fx->normal);
+            fx->count++;
+            return;
+        }
+    }
+
+    if (num_damage_effects == MAX_DAMAGE_EFFECTS) {
+        WriteDamage(type, origin, normal);
+        return;
+    }
+
+    fx->targ = targ;
+    fx->type = type;
+    fx->count = 1;
+    VectorCopy(origin, fx->origin);
+    VectorCopy(normal, fx->normal);
+    VectorCopy(normal, fx->first);
+    num_damage_effects++;
+}
+
+/*
+================
+G_FlushDamageEffects
+
+Sends damage effects accumulated during this frame.
+================
+*/
+void G_FlushDamageEffects(void)
+{
+    damagefx_t *fx;
+    int i;
+
+    for (i = 0, fx = damage_effects; i < num_damage_effects; i++, fx++) {
+        if (fx->count > 1) {
+            VectorScale(fx->origin, 1.0f / fx->count, fx->origin);
+            if (!VectorNormalize(fx->normal)) {
+                // hits from opposite sides cancelled out
+                VectorCopy(fx->first, fx->normal);
+            }
+        }
+        WriteDamage(fx->type, fx->origin, fx->normal);
+    }
+
+    num_damage_effects = 0;
+}
+
+/*
+================
+G_ClearDamageEffects
+
+Drops pending damage effects on level change.
+================
+*/
+void G_ClearDamageEffects(void)
+{
+    num_damage_effects = 0;
+}
+
 
 /*
 ============
@@ -198,7 +290,7 @@ static int CheckPowerArmor(edict_t *ent, vec3_t point, vec3_t normal, int damage
     if (save > damage)
         save = damage;
 
-    SpawnDamage(pa_te_type, point, normal);
+    SpawnDamage(ent, pa_te_type, point, normal);
     client->powerarmor_framenum = level.framenum + 0.2 * HZ;
 
     power_used = save / damagePerCell;
@@ -242,7 +334,7 @@ static int CheckArmor(edict_t *ent, vec3_t point, vec3_t normal, int damage, int
         return 0;
 
     client->inventory[index] -= save;
-    SpawnDamage(te_sparks, point, normal);
+    SpawnDamage(ent, te_sparks, point, normal);
 
     return save;
 }
@@ -320,7 +412,7 @@ void T_Damage(edict_t *targ, edict_t *inflictor, edict_t *attacker, vec3_t dir,
     if ((targ->flags & FL_GODMODE) && !(dflags & DAMAGE_NO_PROTECTION)) {
         take = 0;
         save = damage;
-        SpawnDamage(te_sparks, point, normal);
+        SpawnDamage(targ, te_sparks, point, normal);
     }
 
     // check for invincibility
@@ -355,13 +447,13 @@ void T_Damage(edict_t *targ, edict_t *inflictor, edict_t *attacker, vec3_t dir,
     if (take) {
         if (client)
             if (targ == attacker)
-                SpawnDamage(TE_BLOOD, targ->s.origin, normal);
+                SpawnDamage(targ, TE_BLOOD, targ->s.origin, normal);
             else
-                SpawnDamage(TE_BLOOD, point, normal);
+                SpawnDamage(targ, TE_BLOOD, point, normal);
         else if (targ == attacker)
-            SpawnDamage(TE_SPARKS, targ->s.origin, normal);
+            SpawnDamage(targ, TE_SPARKS, targ->s.origin, normal);
         else
-            SpawnDamage(TE_SPARKS, point, normal);
+            SpawnDamage(targ, TE_SPARKS, point, normal);
 
         targ->health -= take;
 
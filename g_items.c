@@ -65,23 +65,61 @@ static qboolean ItemBanned(edict_t *ent);
 
 //======================================================================
 
-/*
-===============
-FindItemByClassname
+#define ITEM_HASH_SIZE  64
 
-===============
-*/
-gitem_t *FindItemByClassname(char *classname)
+typedef struct itemname_s {
+    const char          *name;
+    gitem_t             *item;
+    struct itemname_s   *next;
+} itemname_t;
+
+static itemname_t   *item_classhash[ITEM_HASH_SIZE];
+static itemname_t   *item_pickuphash[ITEM_HASH_SIZE];
+static itemname_t   item_names[ITEM_TOTAL * 2];
+static qboolean     item_hashed;
+
+static void AddItemName(itemname_t **table, itemname_t *n, const char *name, gitem_t *it)
 {
-    int     i;
+    unsigned hash = G_HashString(name, strlen(name), ITEM_HASH_SIZE);
+
+    n->name = name;
+    n->item = it;
+    n->next = table[hash];
+    table[hash] = n;
+}
+
+static void HashItemNames(void)
+{
+    itemname_t *n = item_names;
     gitem_t *it;
+    int i;
 
-    for (i = 0; i < ITEM_TOTAL; i++) {
+    // add in reverse order so that the first matching item is found first
+    for (i = ITEM_TOTAL - 1; i >= 0; i--) {
         it = INDEX_ITEM(i);
-        if (!it->classname)
-            continue;
-        if (!Q_stricmp(it->classname, classname))
-            return it;
+        if (it->classname) {
+            AddItemName(item_classhash, n++, it->classname, it);
+        }
+        if (it->pickup_name) {
+            AddItemName(item_pickuphash, n++, it->pickup_name, it);
+        }
+    }
+
+    item_hashed = qtrue;
+}
+
+static gitem_t *FindItemName(itemname_t **table, const char *name)
+{
+    itemname_t *n;
+
+    if (!item_hashed) {
+        HashItemNames();
+    }
+
+    for (n = table[G_HashString(name, strlen(name), ITEM_HASH_SIZE)]; n; n = n->next) {
+        if (!Q_stricmp(n->name, name)) {
+            return n->item;
+        }
     }
 
     return NULL;
@@ -89,48 +127,44 @@ gitem_t *FindItemByClassname(char *classname)
 
 /*
 ===============
-FindItem
+FindItemByClassname
 
 ===============
 */
-gitem_t *FindItem(char *pickup_name)
+gitem_t *FindItemByClassname(char *classname)
 {
-    int     i;
-    gitem_t *it;
+    return FindItemName(item_classhash, classname);
+}
 
-    for (i = 0; i < ITEM_TOTAL; i++) {
-        it = INDEX_ITEM(i);
-        if (!it->pickup_name)
-            continue;
-        if (!Q_stricmp(it->pickup_name, pickup_name))
-            return it;
-    }
+/*
+===============
+FindItem
 
-    return NULL;
+===============
+*/
+gitem_t *FindItem(char *pickup_name)
+{
+    return FindItemName(item_pickuphash, pickup_name);
 }
 
 //======================================================================
 
 static edict_t *PickMate(edict_t *ent)
 {
-    edict_t *edicts[256], *e;
-    int count;
+    edict_t *pick = ent, *e;
+    int count = 0;
 
-    for (count = 0, e = ent->teammaster; e; e = e->chain) {
+    // pick uniformly among allowed teammates in a single pass
+    for (e = ent->teammaster; e; e = e->chain) {
         if (ItemBanned(e)) {
             continue;
         }
-        edicts[count++] = e;
-        if (count == 256) {
-            break;
+        if (random() * ++count <= 1) {
+            pick = e;
         }
     }
-    if (!count) {
-        return ent;
-    }
 
-    e = edicts[rand_byte() % count];
-    return e;
+    return pick;
 }
 
 static void DoRespawn(edict_t *ent)
@@ -751,11 +785,40 @@ void Drop_PowerArmor(edict_t *ent, gitem_t *item)
 
 //======================================================================
 
+/*
+===============
+G_BeginItemStats
+
+Item misses are not counted on each pickup. Instead, global pickup
+counters are remembered when client enters the game and misses are
+derived from them when needed.
+===============
+*/
+void G_BeginItemStats(gclient_t *c)
+{
+    int i;
+
+    for (i = 0; i < ITEM_TOTAL; i++) {
+        c->resp.items[i].base = level.item_pickups[i] - c->resp.items[i].pickups;
+    }
+    c->resp.itemstats = qtrue;
+}
+
+int G_ItemMisses(gclient_t *c, int index)
+{
+    itemstat_t *is = &c->resp.items[index];
+
+    if (!c->resp.itemstats) {
+        return 0;
+    }
+
+    return level.item_pickups[index] - is->base - is->pickups;
+}
+
 // stolen from OpenTDM
 static void AccountItemPickup(edict_t *ent, edict_t *other)
 {
-    gclient_t *c;
-    int i, index = ITEM_INDEX(ent->item);
+    int index = ITEM_INDEX(ent->item);
 
     // its health, but not megahealth
     if (index == ITEM_HEALTH && !(ent->style & HEALTH_TIMED))
@@ -779,15 +842,35 @@ static void AccountItemPickup(edict_t *ent, edict_t *other)
 
     // by now we should have everything else - armor, weapons, powerups and mh
     other->client->resp.items[index].pickups++;
-
-    for (i = 0, c = game.clients; i < game.maxclients; i++, c++) {
-        if (c->pers.connected == CONN_SPAWNED && c != other->client) {
-            c->resp.items[index].misses++;
-        }
-    }
+    level.item_pickups[index]++;
 }
 
 
+static int HealthSound(int count)
+{
+    static const char *const names[4] = {
+        "items/s_health.wav",
+        "items/n_health.wav",
+        "items/l_health.wav",
+        "items/m_health.wav"
+    };
+    int i;
+
+    if (count == 2)
+        i = 0;
+    else if (count == 10)
+        i = 1;
+    else if (count == 25)
+        i = 2;
+    else // (count == 100)
+        i = 3;
+
+    if (!level.sounds.health[i])
+        level.sounds.health[i] = gi.soundindex(names[i]);
+
+    return level.sounds.health[i];
+}
+
 /*
 ===============
 Touch_Item
@@ -813,7 +896,7 @@ void Touch_Item(edict_t *ent, edict_t *other, cplane_t *plane, csurface_t *surf)
         other->client->bonus_alpha = 0.25;
 
         // show icon and name on status bar
-        other->client->ps.stats[STAT_PICKUP_ICON] = gi.imageindex(ent->item->icon);
+        other->client->ps.stats[STAT_PICKUP_ICON] = G_ItemIcon(ent->item);
         other->client->ps.stats[STAT_PICKUP_STRING] = CS_ITEMS + ITEM_INDEX(ent->item);
         other->client->pickup_framenum = level.framenum + 3 * HZ;
 
@@ -822,16 +905,9 @@ void Touch_Item(edict_t *ent, edict_t *other, cplane_t *plane, csurface_t *surf)
             other->client->selected_item = other->client->ps.stats[STAT_SELECTED_ITEM] = ITEM_INDEX(ent->item);
 
         if (ent->item->pickup == Pickup_Health) {
-            if (ent->count == 2)
-                gi.sound(other, CHAN_ITEM, gi.soundindex("items/s_health.wav"), 1, ATTN_NORM, 0);
-            else if (ent->count == 10)
-                gi.sound(other, CHAN_ITEM, gi.soundindex("items/n_health.wav"), 1, ATTN_NORM, 0);
-            else if (ent->count == 25)
-                gi.sound(other, CHAN_ITEM, gi.soundindex("items/l_health.wav"), 1, ATTN_NORM, 0);
-            else // (ent->count == 100)
-                gi.sound(other, CHAN_ITEM, gi.soundindex("items/m_health.wav"), 1, ATTN_NORM, 0);
+            gi.sound(other, CHAN_ITEM, HealthSound(ent->count), 1, ATTN_NORM, 0);
         } else if (ent->item->pickup_sound) {
-            gi.sound(other, CHAN_ITEM, gi.soundindex(ent->item->pickup_sound), 1, ATTN_NORM, 0);
+            gi.sound(other, CHAN_ITEM, G_ItemSound(ent->item), 1, ATTN_NORM, 0);
         }
     }
 
@@ -1038,13 +1114,13 @@ void PrecacheItem(gitem_t *it)
         return;
 
     if (it->pickup_sound)
-        gi.soundindex(it->pickup_sound);
+        level.sounds.items[ITEM_INDEX(it)] = gi.soundindex(it->pickup_sound);
     if (it->world_model)
         gi.modelindex(it->world_model);
     if (it->view_model)
         gi.modelindex(it->view_model);
     if (it->icon)
-        gi.imageindex(it->icon);
+        level.images.items[ITEM_INDEX(it)] = gi.imageindex(it->icon);
 
     // parse everything for its ammo
     if (it->ammo && it->ammo[0]) {
@@ -1083,6 +1159,41 @@ void PrecacheItem(gitem_t *it)
     }
 }
 
+/*
+===============
+G_ItemIcon
+
+Returns image index of item icon. Normally it is resolved by PrecacheItem,
+items that weren't precached are resolved on first use.
+===============
+*/
+int G_ItemIcon(const gitem_t *it)
+{
+    int *index = &level.images.items[ITEM_INDEX(it)];
+
+    if (!*index && it->icon)
+        *index = gi.imageindex(it->icon);
+
+    return *index;
+}
+
+/*
+===============
+G_ItemSound
+
+Same as above, for item pickup sound.
+===============
+*/
+int G_ItemSound(const gitem_t *it)
+{
+    int *index = &level.sounds.items[ITEM_INDEX(it)];
+
+    if (!*index && it->pickup_sound)
+        *index = gi.soundindex(it->pickup_sound);
+
+    return *index;
+}
+
 /*
 ============
 SpawnItem
@@ -1129,6 +1240,7 @@ void SpawnItem(edict_t *ent, gitem_t *item)
     }
 
     ent->item = item;
+    List_Append(&level.item_lists[ITEM_INDEX(item)], &ent->item_entry);
     ent->nextthink = level.framenum + 2;    // items start after other solids
     ent->think = droptofloor;
     ent->s.effects = item->world_model_flags;
@@ -1137,23 +1249,28 @@ void SpawnItem(edict_t *ent, gitem_t *item)
         gi.modelindex(ent->model);
 }
 
-static qboolean ItemBanned(edict_t *ent)
+static int ItemBanBit(const gitem_t *item)
 {
-    int itb = (int)g_item_ban->value;
+    if (item->use == Use_Quad) {
+        return ITB_QUAD;
+    }
+    if (item->use == Use_Invulnerability) {
+        return ITB_INVUL;
+    }
+    if (item->weapmodel == WEAP_BFG) {
+        return ITB_BFG;
+    }
+    if (item->use == Use_PowerArmor) {
+        return ITB_PS;
+    }
 
+    return 0;
+}
+
+static qboolean ItemBanned(edict_t *ent)
+{
     if (ent->item) {
-        if (ent->item->use == Use_Quad) {
-            return !!(itb & ITB_QUAD);
-        }
-        if (ent->item->use == Use_Invulnerability) {
-            return !!(itb & ITB_INVUL);
-        }
-        if (ent->item->weapmodel == WEAP_BFG) {
-            return !!(itb & ITB_BFG);
-        }
-        if (ent->item->use == Use_PowerArmor) {
-            return !!(itb & ITB_PS);
-        }
+        return !!((int)g_item_ban->value & ItemBanBit(ent->item));
     }
 
     return qfalse;
@@ -1164,21 +1281,20 @@ void G_UpdateItemBans(void)
     int i;
     edict_t *ent;
 
-    for (i = game.maxclients + BODY_QUEUE_SIZE + 1; i < globals.num_edicts; i++) {
-        ent = &g_edicts[i];
-        if (!ent->inuse || !ent->item) {
-            continue;
-        }
-        if ((ent->spawnflags & (DROPPED_ITEM | DROPPED_PLAYER_ITEM))) {
+    // only items that can be banned need to be visited
+    for (i = 0; i < ITEM_TOTAL; i++) {
+        if (!ItemBanBit(INDEX_ITEM(i))) {
             continue;
         }
-        if (ItemBanned(ent)) {
-            if (!(ent->flags & FL_HIDDEN) && !(ent->svflags & SVF_NOCLIENT)) {
-                // give teammates a chance to respawn
-                SetRespawn(ent, 2);
+        LIST_FOR_EACH(edict_t, ent, &level.item_lists[i], item_entry) {
+            if (ItemBanned(ent)) {
+                if (!(ent->flags & FL_HIDDEN) && !(ent->svflags & SVF_NOCLIENT)) {
+                    // give teammates a chance to respawn
+                    SetRespawn(ent, 2);
+                }
+            } else if (ent->flags & FL_HIDDEN) {
+                SetUnhide(ent);
             }
-        } else if (ent->flags & FL_HIDDEN) {
-            SetUnhide(ent);
         }
     }
 
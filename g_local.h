@@ -67,6 +67,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define svc_layout          4
 #define svc_inventory       5
 #define svc_sound           9
+#define svc_print           10
 #define svc_stufftext       11
 #define svc_configstring    13
 
@@ -384,6 +385,24 @@ typedef struct skin_entry_s {
     char name[1];
 } skin_entry_t;
 
+// cached result of player to player visibility check
+typedef struct {
+    int         expires;        // level.framenum when result becomes stale
+    qboolean    visible;
+} visibility_t;
+
+// token bucket used to limit client command rate
+typedef struct {
+    float       tokens;
+    int         framenum;       // when tokens were last refilled, 0 if full
+} ratelimit_t;
+
+// command rate limit shared by all clients from the same address
+typedef struct {
+    char        address[32];    // without port
+    ratelimit_t limit;
+} addrlimit_t;
+
 //
 // this structure is left intact through an entire game
 // it should be initialized at dll load time, and read/written to
@@ -391,6 +410,8 @@ typedef struct skin_entry_s {
 //
 typedef struct {
     gclient_t   *clients;       // [maxclients]
+    visibility_t    *visibility;    // [maxclients * maxclients]
+    addrlimit_t *addrlimits;    // [maxclients]
 
     // scoreboard layout from previous level
     char        oldscores[MAX_STRING_CHARS];
@@ -490,6 +511,18 @@ typedef struct {
     int         players_in;
     int         players_out;
 
+    gclient_t   *ranks[MAX_CLIENTS];    // spawned clients, best first
+    int         numranks;
+
+    struct {
+        char        layout[MAX_STRING_CHARS];   // shared by all clients
+        size_t      length;
+        short       rows[MAX_CLIENTS];  // where to unhighlight own row
+        int         framenum;           // when layout was built
+        int         version;            // bumped each time layout changes
+        qboolean    dirty;              // ranks changed since last build
+    } scoreboard;
+
     struct {
         int     health;
         int     powershield;
@@ -501,6 +534,7 @@ typedef struct {
         int     invulnerability;
         int     envirosuit;
         int     rebreather;
+        int     items[ITEM_TOTAL];      // item icons
     } images;
 
     struct {
@@ -526,6 +560,9 @@ typedef struct {
         int     jump;
         int     pain[4][2];
 
+        int     items[ITEM_TOTAL];      // item pickup sounds
+        int     health[4];              // small, medium, large, mega
+
         int     secret;
         int     count;
         int     xian;
@@ -539,6 +576,10 @@ typedef struct {
         int     arm, leg, chest, bones[2];
     } models;
 
+    int         item_pickups[ITEM_TOTAL];   // tracked pickups by all players
+    list_t      item_lists[ITEM_TOTAL];     // items placed in the world
+    list_t      free_edicts;                // in order they were freed
+
     struct {
         int     proposal;
         int     index;
@@ -548,6 +589,10 @@ typedef struct {
         struct gclient_s    *victim;
         struct gclient_s    *initiator;
         char    map[MAX_QPATH];
+
+        int     voters;         // number of clients allowed to vote
+        int     tally[2][2];    // [admin][accepted]
+        qboolean    changed;    // tally changed since last CS_VOTE_COUNT update
     } vote;
 
     edict_t     *current_entity;    // entity running from G_RunFrame
@@ -627,6 +672,7 @@ typedef struct map_entry_s {
 } map_entry_t;
 
 struct flood_s;
+struct lifestats_s;
 
 extern  const gitem_t   g_itemlist[ITEM_TOTAL];
 
@@ -728,11 +774,15 @@ extern  cvar_t  *g_spawn_mode;
 extern  cvar_t  *g_team_chat;
 extern  cvar_t  *g_mute_chat;
 extern  cvar_t  *g_protection_time;
+extern  cvar_t  *g_viewid_frames;
+extern  cvar_t  *g_debug_stats;
 extern  cvar_t  *dedicated;
 
 #if USE_SQLITE
 extern  cvar_t  *g_sql_database;
 extern  cvar_t  *g_sql_async;
+extern  cvar_t  *g_sql_retention;
+extern  cvar_t  *g_sql_batch;
 #endif
 
 extern  cvar_t  *sv_gravity;
@@ -763,6 +813,10 @@ extern  cvar_t  *flood_wavedelay;
 extern  cvar_t  *flood_infos;
 extern  cvar_t  *flood_perinfo;
 extern  cvar_t  *flood_infodelay;
+extern  cvar_t  *flood_cmdrate;
+extern  cvar_t  *flood_cmdburst;
+extern  cvar_t  *flood_addrrate;
+extern  cvar_t  *flood_addrburst;
 
 extern  list_t  g_map_list;
 extern  list_t  g_map_queue;
@@ -803,11 +857,13 @@ void Cmd_Players_f(edict_t *ent);
 void Cmd_HighScores_f(edict_t *ent);
 void Cmd_Stats_f(edict_t *ent, qboolean check_other);
 void Cmd_Settings_f(edict_t *ent);
+void G_CommandStats_f(void);
 edict_t *G_SetPlayer(edict_t *ent, int arg);
 edict_t *G_SetVictim(edict_t *ent, int start);
 void ValidateSelectedItem(edict_t *ent);
 qboolean G_FloodProtect(edict_t *ent, struct flood_s *flood,
                         const char *what, int msgs, float persecond, float delay);
+void G_PrintLifeStats(edict_t *ent, const char *name, const struct lifestats_s *s);
 
 //
 // g_items.c
@@ -816,6 +872,10 @@ qboolean G_FloodProtect(edict_t *ent, struct flood_s *flood,
 #define INDEX_ITEM(x) ((gitem_t *)&g_itemlist[(x)])
 
 void PrecacheItem(gitem_t *it);
+int G_ItemIcon(const gitem_t *it);
+int G_ItemSound(const gitem_t *it);
+void G_BeginItemStats(gclient_t *c);
+int G_ItemMisses(gclient_t *c, int index);
 void InitItems(void);
 void SetItemNames(void);
 gitem_t *FindItem(char *pickup_name);
@@ -838,6 +898,7 @@ qboolean    G_KillBox(edict_t *ent);
 void    G_ProjectSource(vec3_t point, vec3_t distance, vec3_t forward, vec3_t right, vec3_t result);
 edict_t *G_Find(edict_t *from, size_t fieldofs, char *match);
 edict_t *findradius(edict_t *from, vec3_t org, float rad);
+int G_FindRadius(vec3_t org, float rad, edict_t **list, int maxcount);
 edict_t *G_PickTarget(char *targetname);
 void    G_UseTargets(edict_t *ent, edict_t *activator);
 void    G_SetMovedir(vec3_t angles, vec3_t movedir);
@@ -855,6 +916,7 @@ size_t  G_HighlightStr(char *dst, const char *src, size_t size);
 
 #define G_Malloc(x) gi.TagMalloc(x, TAG_GAME)
 char    *G_CopyString(const char *in);
+unsigned G_HashString(const char *s, size_t len, unsigned size);
 
 float   *tv(float x, float y, float z);
 char    *vtos(vec3_t v);
@@ -869,6 +931,8 @@ qboolean OnSameTeam(edict_t *ent1, edict_t *ent2);
 qboolean CanDamage(edict_t *targ, edict_t *inflictor);
 void T_Damage(edict_t *targ, edict_t *inflictor, edict_t *attacker, vec3_t dir, vec3_t point, vec3_t normal, int damage, int knockback, int dflags, int mod);
 void T_RadiusDamage(edict_t *inflictor, edict_t *attacker, float damage, edict_t *ignore, float radius, int mod);
+void G_FlushDamageEffects(void);
+void G_ClearDamageEffects(void);
 
 // damage flags
 #define DAMAGE_RADIUS           0x00000001  // damage was indirect
@@ -962,8 +1026,9 @@ void IntermissionEndServerFrame(edict_t *ent);
 void MoveClientToIntermission(edict_t *client);
 void G_PrivateString(edict_t *ent, int index, const char *string);
 int G_GetPlayerIdView(edict_t *ent);
+void G_ResetVisibility(void);
 void G_SetStats(edict_t *ent);
-int G_CalcRanks(gclient_t **ranks);
+void G_SortRank(gclient_t *c);
 void DeathmatchScoreboardMessage(edict_t *ent, qboolean reliable);
 void HighScoresMessage(void);
 
@@ -1049,6 +1114,7 @@ typedef struct pmenu_entry_s {
 typedef struct pmenu_s {
     int cur;
     pmenu_entry_t entries[MAX_MENU_ENTRIES];
+    struct pmenu_layout_s *layout;  // last used rendered layout
 } pmenu_t;
 
 typedef enum {
@@ -1137,10 +1203,20 @@ typedef struct {
 
 typedef struct {
     int pickups;
-    int misses;
+    int base;       // level.item_pickups when client entered the game
     int kills;
 } itemstat_t;
 
+// lifetime totals loaded from the stats database
+typedef struct lifestats_s {
+    int         sessions;
+    int         time;
+    int         score;
+    int         deaths;
+    int         damage_given, damage_recvd;
+    fragstat_t  frags[FRAG_TOTAL];
+} lifestats_t;
+
 #define FLOOD_MSGS  10
 typedef struct flood_s {
     int     locktill;           // locked from talking
@@ -1157,6 +1233,7 @@ typedef struct {
     float       fov;
     gender_t    gender;
     int         uf;
+    int         msglevel;       // engine drops prints below this level
     conn_t      connected;
     qboolean    loopback: 1,
                 mvdspec: 1,
@@ -1174,6 +1251,7 @@ typedef struct {
     int         deaths;
     fragstat_t  frags[FRAG_TOTAL];
     itemstat_t  items[ITEM_TOTAL];
+    qboolean    itemstats;          // item misses are being counted
     int         damage_given, damage_recvd;
 } client_respawn_t;
 
@@ -1183,13 +1261,21 @@ typedef struct {
     qboolean    first_time : 1,     // true when just connected
                 jump_held: 1;
     vec3_t      cmd_angles;         // angles sent over in the last command
+    int         rank;               // 1-based index into level.ranks, 0 if not in game
     char        strings[PCS_TOTAL][MAX_NETNAME]; // private configstrings
+    int         hud_rank, hud_total, hud_delta; // what PCS_RANK and PCS_DELTA show, 0 rank if nothing
+    int         scoreboard;         // version of scoreboard layout last sent, 0 if other layout
+    list_t      chasers;            // spectators chasing this client
+    list_t      chase_entry;        // link in chase target's chasers list
     struct {
         int         index;
         qboolean    accepted;
         int         count;
+        qboolean    voter;      // counted in level.vote.voters
+        int         *cast;      // counter in level.vote.tally, if any
     } vote;
     flood_t     chat_flood, wave_flood, info_flood;
+    ratelimit_t cmd_limit;
 } client_level_t;
 
 // this structure is cleared on each PutClientInServer(),
@@ -1284,11 +1370,39 @@ struct gclient_s {
 
     int         pickup_framenum;
 
+    // inputs of stats that G_SetStats updates only when changed
+    struct {
+        qboolean    valid;
+        int         ammo_index, ammo;
+        int         power_armor, cells;
+        int         armor_index, armor, armor_flash;
+        int         quad, enviro, breather, invincible;
+#ifdef XATRIX
+        float       quadfire;
+#endif //XATRIX
+        int         timer_framenum;     // when timer values change next
+        int         selected_item;
+        qboolean    helpicon;
+        gitem_t     *weapon;
+    } statcache;
+
     int         respawn_framenum;   // can respawn when time > this
 
     edict_t         *chase_target;      // player we are chasing
     chase_mode_t    chase_mode;
 
+    // computed once per frame for all spectators chasing this client
+    struct {
+        int         cam_framenum;
+        qboolean    onground;
+        int         viewheight;
+        vec3_t      origin, angles;     // camera was computed for
+        vec3_t      goal;
+
+        int         viewid_framenum;
+        int         viewid;
+    } chasecache;
+
     int         selected_item;
     int         inventory[MAX_ITEMS];
 
@@ -1347,6 +1461,7 @@ struct edict_s {
 
     char        *model;
     float       freetime;           // sv.time when the object was freed
+    list_t      free_entry;         // link in level.free_edicts
 
     //
     // only used locally in game, not by server
@@ -1449,6 +1564,7 @@ struct edict_s {
     int         style;          // also used as areaportal number
 
     gitem_t     *item;          // for bonus items
+    list_t      item_entry;     // link in level.item_lists if placed in the world
 
     // common data blocks
     moveinfo_t      moveinfo;
@@ -1483,11 +1599,14 @@ void ChasePrev(edict_t *ent);
 qboolean GetChaseTarget(edict_t *ent, chase_mode_t mode);
 void SetChaseTarget(edict_t *ent, edict_t *targ);
 void UpdateChaseTargets(chase_mode_t mode, edict_t *targ);
+void ChaseDisconnect(edict_t *ent);
 
 //
 // g_vote.c
 //
 void G_FinishVote(void);
+void G_UpdateVoter(gclient_t *c);
+void G_RecountVotes(void);
 void G_UpdateVote(void);
 qboolean G_CheckVote(void);
 void Cmd_Vote_f(edict_t *ent);
@@ -1518,6 +1637,10 @@ void G_BeginLogging(void);
 void G_EndLogging(void);
 void G_LogClient(gclient_t *c);
 void G_LogClients(void);
+void G_StartRetention(void);
+void G_RunRetention(void);
+void G_QueryLifeStats(edict_t *ent, const char *name);
+void G_RunQueries(void);
 qboolean G_OpenDatabase(void);
 void G_CloseDatabase(void);
 #endif
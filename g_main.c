@@ -55,6 +55,8 @@ cvar_t  *g_spawn_mode;
 cvar_t  *g_team_chat;
 cvar_t  *g_mute_chat;
 cvar_t  *g_protection_time;
+cvar_t  *g_viewid_frames;
+cvar_t  *g_debug_stats;
 cvar_t  *g_log_stats;
 cvar_t  *g_skins_file;
 cvar_t  *dedicated;
@@ -62,6 +64,8 @@ cvar_t  *dedicated;
 #if USE_SQLITE
 cvar_t  *g_sql_database;
 cvar_t  *g_sql_async;
+cvar_t  *g_sql_retention;
+cvar_t  *g_sql_batch;
 #endif
 
 cvar_t  *sv_maxvelocity;
@@ -93,6 +97,10 @@ cvar_t  *flood_wavedelay;
 cvar_t  *flood_infos;
 cvar_t  *flood_perinfo;
 cvar_t  *flood_infodelay;
+cvar_t  *flood_cmdrate;
+cvar_t  *flood_cmdburst;
+cvar_t  *flood_addrrate;
+cvar_t  *flood_addrburst;
 
 #ifdef XATRIX
 cvar_t	*xatrix;			//set when xatrix mission pack 1 is enabled
@@ -237,19 +245,16 @@ static void G_SaveScores(void)
 
 static void G_RegisterScore(void)
 {
-    gclient_t    *ranks[MAX_CLIENTS];
     gclient_t    *c;
     score_t *s;
-    int total;
     int sec, score;
 
-    total = G_CalcRanks(ranks);
-    if (!total) {
+    if (!level.numranks) {
         return;
     }
 
     // grab our champion
-    c = ranks[0];
+    c = level.ranks[0];
 
     // calculate FPH
     sec = (level.framenum - c->resp.enter_framenum) / HZ;
@@ -405,7 +410,7 @@ done:
 
 static map_entry_t *G_FindSuitableMap(void)
 {
-    int total = G_CalcRanks(NULL);
+    int total = level.numranks;
     map_entry_t *map;
 
     LIST_FOR_EACH(map_entry_t, map, &g_map_queue, queue) {
@@ -682,6 +687,7 @@ static void CheckDMRules(void)
     }
 
     if (g_vote_flags->modified) {
+        G_RecountVotes();
         G_CheckVote();
         g_vote_flags->modified = qfalse;
     }
@@ -871,6 +877,11 @@ void G_RunFrame(void)
                 }
             }
         }
+
+#if USE_SQLITE
+        // expire old stats while nobody is playing
+        G_RunRetention();
+#endif
     } else {
 #if 0
         if (level.warmup_framenum) {
@@ -904,6 +915,14 @@ void G_RunFrame(void)
         }
     }
 
+#if USE_SQLITE
+    // deliver finished database queries
+    G_RunQueries();
+#endif
+
+    // send damage effects merged during this frame
+    G_FlushDamageEffects();
+
     // build the playerstate_t structures for all players
     ClientEndServerFrames();
 
@@ -1031,9 +1050,13 @@ static void G_Init(void)
     g_team_chat = gi.cvar("g_team_chat", "0", 0);
     g_mute_chat = gi.cvar("g_mute_chat", "0", 0);
     g_protection_time = gi.cvar("g_protection_time", "0", 0);
+    g_viewid_frames = gi.cvar("g_viewid_frames", "2", 0);
+    g_debug_stats = gi.cvar("g_debug_stats", "0", 0);
 #if USE_SQLITE
     g_sql_database = gi.cvar("g_sql_database", "", 0);
     g_sql_async = gi.cvar("g_sql_async", "0", 0);
+    g_sql_retention = gi.cvar("g_sql_retention", "0", 0);
+    g_sql_batch = gi.cvar("g_sql_batch", "100", 0);
 #endif
     g_skins_file = gi.cvar("g_skins_file", "", CVAR_LATCH);
 
@@ -1057,6 +1080,10 @@ static void G_Init(void)
     flood_infos = gi.cvar("flood_infos", "4", 0);
     flood_perinfo = gi.cvar("flood_perinfo", "30", 0);
     flood_infodelay = gi.cvar("flood_infodelay", "60", 0);
+    flood_cmdrate = gi.cvar("flood_cmdrate", "2", 0);
+    flood_cmdburst = gi.cvar("flood_cmdburst", "20", 0);
+    flood_addrrate = gi.cvar("flood_addrrate", "8", 0);
+    flood_addrburst = gi.cvar("flood_addrburst", "60", 0);
 
     // Nick - Ripper self hurt
 #ifdef XATRIX
@@ -1085,6 +1112,8 @@ static void G_Init(void)
     // initialize all clients for this game
     game.maxclients = maxclients->value;
     game.clients = G_Malloc(game.maxclients * sizeof(game.clients[0]));
+    game.visibility = G_Malloc(game.maxclients * game.maxclients * sizeof(game.visibility[0]));
+    game.addrlimits = G_Malloc(game.maxclients * sizeof(game.addrlimits[0]));
     globals.num_edicts = game.maxclients + 1;
 
     // obtain game path
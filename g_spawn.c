@@ -586,6 +586,13 @@ void G_SpawnEntities(const char *mapname, const char *entities, const char *spaw
 
     memset(&level, 0, sizeof(level));
     memset(g_edicts, 0, game.maxentities * sizeof(g_edicts[0]));
+    G_ResetVisibility();
+    G_ClearDamageEffects();
+    for (i = 0; i < ITEM_TOTAL; i++) {
+        List_Init(&level.item_lists[i]);
+    }
+    List_Init(&level.free_edicts);
+    globals.num_edicts = game.maxclients + 1;
 
     Q_strlcpy(level.mapname, mapname, sizeof(level.mapname));
 
@@ -609,6 +616,8 @@ void G_SpawnEntities(const char *mapname, const char *entities, const char *spaw
         client->edict = ent;
         client->clientNum = i;
         client->pers.connected = CONN_CONNECTED;
+        List_Init(&client->level.chasers);
+        List_Init(&client->level.chase_entry);
 
         // combine name and skin into a configstring
         Q_concat(playerskin, sizeof(playerskin),
@@ -669,6 +678,8 @@ void G_ResetLevel(void)
     level.nextmap[0] = 0;
     level.record = 0;
     level.players_in = level.players_out = 0;
+    G_ResetVisibility();
+    G_ClearDamageEffects();
 
     // free all edicts
     for (i = game.maxclients + 1; i < globals.num_edicts; i++) {
@@ -697,11 +708,13 @@ void G_ResetLevel(void)
         if (client->pers.connected == CONN_SPAWNED) {
             ent = client->edict;
             G_ScoreChanged(ent);
+            G_BeginItemStats(client);
             ent->movetype = MOVETYPE_NOCLIP; // do not leave body
             respawn(ent);
         }
     }
 
+    G_RecountVotes();
     G_UpdateRanks();
 
     if (timelimit->value > 0) {
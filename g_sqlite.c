@@ -21,7 +21,46 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "g_local.h"
 #include <sqlite3.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+typedef HANDLE              thread_t;
+typedef CRITICAL_SECTION    mutex_t;
+typedef CONDITION_VARIABLE  cond_t;
+#define mutex_init(m)       InitializeCriticalSection(m)
+#define mutex_destroy(m)    DeleteCriticalSection(m)
+#define mutex_lock(m)       EnterCriticalSection(m)
+#define mutex_unlock(m)     LeaveCriticalSection(m)
+#define cond_init(c)        InitializeConditionVariable(c)
+#define cond_destroy(c)     (void)0
+#define cond_wait(c, m)     SleepConditionVariableCS(c, m, INFINITE)
+#define cond_signal(c)      WakeConditionVariable(c)
+#define THREAD_FUNC         unsigned __stdcall
+#define THREAD_RETURN       0
+#define thread_create(t, f) \
+    ((*(t) = (HANDLE)_beginthreadex(NULL, 0, f, NULL, 0, NULL)) != NULL)
+#define thread_join(t)      (WaitForSingleObject(t, INFINITE), CloseHandle(t))
+#else
+#include <pthread.h>
+typedef pthread_t           thread_t;
+typedef pthread_mutex_t     mutex_t;
+typedef pthread_cond_t      cond_t;
+#define mutex_init(m)       pthread_mutex_init(m, NULL)
+#define mutex_destroy(m)    pthread_mutex_destroy(m)
+#define mutex_lock(m)       pthread_mutex_lock(m)
+#define mutex_unlock(m)     pthread_mutex_unlock(m)
+#define cond_init(c)        pthread_cond_init(c, NULL)
+#define cond_destroy(c)     pthread_cond_destroy(c)
+#define cond_wait(c, m)     pthread_cond_wait(c, m)
+#define cond_signal(c)      pthread_cond_signal(c)
+#define THREAD_FUNC         void *
+#define THREAD_RETURN       NULL
+#define thread_create(t, f) (pthread_create(t, NULL, f, NULL) == 0)
+#define thread_join(t)      pthread_join(t, NULL)
+#endif
+
 static sqlite3 *db;
+static char db_path[MAX_OSPATH];
 
 static unsigned long long rowid;
 static unsigned long updated;
@@ -91,7 +130,7 @@ void G_LogClient( gclient_t *c ) {
     unsigned long clock;
     fragstat_t *fs;
     itemstat_t *is;
-    int i, ret;
+    int i, ret, sec, misses;
 
     if( !db ) {
         return;
@@ -124,8 +163,20 @@ void G_LogClient( gclient_t *c ) {
     // PlayerBegin \name\%s\id\%s
     // PlayerEnd \name\%s\id\%s
     // PlayerStats \name\%s\id\%s\time\%d\frg\%d\dth\%d\dmg\%d\dmr\%d\w%d\%d,%d,%d,%d,%d\i%d\%d,%d,%d
+    sec = ( level.framenum - c->resp.enter_framenum ) / HZ;
+
     db_execute( "INSERT INTO records VALUES(%llu,%lu,%d,%d,%d,%d,%d)",
-        rowid, clock, ( level.framenum - c->resp.enter_framenum ) / HZ,
+        rowid, clock, sec,
+        c->resp.score, c->resp.deaths, c->resp.damage_given, c->resp.damage_recvd );
+
+    // keep lifetime totals up to date for cheap lookups
+    db_execute( "INSERT INTO player_totals VALUES(%llu,1,%d,%d,%d,%d,%d) "
+        "ON CONFLICT(player_id) DO UPDATE SET "
+        "sessions=sessions+1,time=time+excluded.time,"
+        "score=score+excluded.score,deaths=deaths+excluded.deaths,"
+        "damage_given=damage_given+excluded.damage_given,"
+        "damage_recvd=damage_recvd+excluded.damage_recvd",
+        rowid, sec,
         c->resp.score, c->resp.deaths, c->resp.damage_given, c->resp.damage_recvd );
 
     for( i = 0; i < FRAG_TOTAL; i++ ) {
@@ -133,14 +184,21 @@ void G_LogClient( gclient_t *c ) {
         if( fs->kills || fs->deaths || fs->suicides || fs->atts || fs->hits ) {
             db_execute( "INSERT INTO frags VALUES(%llu,%lu,%d,%d,%d,%d,%d,%d)",
                 rowid, clock, i, fs->kills, fs->deaths, fs->suicides, fs->atts, fs->hits );
+            db_execute( "INSERT INTO frag_totals VALUES(%llu,%d,%d,%d,%d,%d,%d) "
+                "ON CONFLICT(player_id,frag) DO UPDATE SET "
+                "kills=kills+excluded.kills,deaths=deaths+excluded.deaths,"
+                "suicides=suicides+excluded.suicides,atts=atts+excluded.atts,"
+                "hits=hits+excluded.hits",
+                rowid, i, fs->kills, fs->deaths, fs->suicides, fs->atts, fs->hits );
         }
     }
 
     for( i = 0; i < ITEM_TOTAL; i++ ) {
         is = &c->resp.items[i];
-        if( is->pickups || is->misses || is->kills ) {
+        misses = G_ItemMisses( c, i );
+        if( is->pickups || misses || is->kills ) {
             db_execute( "INSERT INTO items VALUES(%llu,%lu,%d,%d,%d,%d)",
-                rowid, clock, i, is->pickups, is->misses, is->kills );
+                rowid, clock, i, is->pickups, misses, is->kills );
         }
     }
 
@@ -160,6 +218,134 @@ void G_LogClients( void ) {
     G_EndLogging();
 }
 
+/*
+Raw rows older than g_sql_retention days are folded into per-player
+daily roll-up tables and then deleted. Rows are appended in clock order,
+so the oldest ones are always found at the beginning of each table. Each
+batch looks at no more than g_sql_batch leading rows, and the table is
+considered done once a batch comes up short.
+*/
+typedef struct {
+    const char *table;
+    const char *rollup;
+} rollup_t;
+
+static const rollup_t rollups[] = {
+    { "records",
+      "INSERT INTO records_daily "
+      "SELECT player_id,clock/86400,COUNT(*),SUM(time),SUM(score),SUM(deaths),"
+      "SUM(damage_given),SUM(damage_recvd) "
+      "FROM records WHERE rowid IN rollup_batch GROUP BY 1,2 "
+      "ON CONFLICT(player_id,day) DO UPDATE SET "
+      "sessions=sessions+excluded.sessions,time=time+excluded.time,"
+      "score=score+excluded.score,deaths=deaths+excluded.deaths,"
+      "damage_given=damage_given+excluded.damage_given,"
+      "damage_recvd=damage_recvd+excluded.damage_recvd" },
+    { "frags",
+      "INSERT INTO frags_daily "
+      "SELECT player_id,clock/86400,frag,SUM(kills),SUM(deaths),SUM(suicides),"
+      "SUM(atts),SUM(hits) "
+      "FROM frags WHERE rowid IN rollup_batch GROUP BY 1,2,3 "
+      "ON CONFLICT(player_id,day,frag) DO UPDATE SET "
+      "kills=kills+excluded.kills,deaths=deaths+excluded.deaths,"
+      "suicides=suicides+excluded.suicides,atts=atts+excluded.atts,"
+      "hits=hits+excluded.hits" },
+    { "items",
+      "INSERT INTO items_daily "
+      "SELECT player_id,clock/86400,item,SUM(pickups),SUM(misses),SUM(kills) "
+      "FROM items WHERE rowid IN rollup_batch GROUP BY 1,2,3 "
+      "ON CONFLICT(player_id,day,item) DO UPDATE SET "
+      "pickups=pickups+excluded.pickups,misses=misses+excluded.misses,"
+      "kills=kills+excluded.kills" }
+};
+
+static int rollup_current = q_countof( rollups );
+static int rollup_total;
+
+static int db_rollup( const rollup_t *r, int batch, unsigned long cutoff ) {
+    int count;
+
+    if( db_execute( "BEGIN TRANSACTION" ) ) {
+        return -1;
+    }
+    if( db_execute( "DELETE FROM rollup_batch" ) ) {
+        goto fail;
+    }
+    if( db_execute( "INSERT INTO rollup_batch SELECT id FROM "
+        "(SELECT rowid AS id,clock FROM %s ORDER BY rowid LIMIT %d) "
+        "WHERE clock<%lu", r->table, batch, cutoff ) ) {
+        goto fail;
+    }
+    count = sqlite3_changes( db );
+    if( count ) {
+        if( db_execute( "%s", r->rollup ) ) {
+            goto fail;
+        }
+        if( db_execute( "DELETE FROM %s WHERE rowid IN rollup_batch", r->table ) ) {
+            goto fail;
+        }
+    }
+    if( db_execute( "COMMIT" ) ) {
+        goto fail;
+    }
+    return count;
+
+fail:
+    db_execute( "ROLLBACK" );
+    return -1;
+}
+
+/*
+==============
+G_StartRetention
+
+Called when intermission begins. Restarts the roll-up job.
+==============
+*/
+void G_StartRetention( void ) {
+    rollup_current = 0;
+    rollup_total = 0;
+}
+
+/*
+==============
+G_RunRetention
+
+Called once per frame during intermission. Processes at most
+one batch of rows, so that it never stalls the server.
+==============
+*/
+void G_RunRetention( void ) {
+    unsigned long cutoff;
+    int batch, count;
+
+    if( !db || g_sql_retention->value <= 0 ) {
+        return;
+    }
+
+    if( rollup_current >= q_countof( rollups ) ) {
+        return;
+    }
+
+    batch = g_sql_batch->value;
+    clamp( batch, 1, 10000 );
+
+    cutoff = time( NULL ) - (unsigned long)( g_sql_retention->value * 86400 );
+
+    count = db_rollup( &rollups[rollup_current], batch, cutoff );
+    if( count < 0 ) {
+        // give up until next intermission
+        rollup_current = q_countof( rollups );
+        return;
+    }
+
+    rollup_total += count;
+    if( count < batch && ++rollup_current == q_countof( rollups ) && rollup_total ) {
+        gi.dprintf( "Rolled up %d SQLite rows older than %g days\n",
+            rollup_total, g_sql_retention->value );
+    }
+}
+
 static const char schema[] =
 "BEGIN TRANSACTION;\n"
 
@@ -205,13 +391,349 @@ static const char schema[] =
 
 "CREATE INDEX IF NOT EXISTS items_idx ON items(player_id,clock);\n"
 
+"CREATE TABLE IF NOT EXISTS records_daily(\n"
+    "player_id INT,\n"
+    "day INT,\n"
+    "sessions INT,\n"
+    "time INT,\n"
+    "score INT,\n"
+    "deaths INT,\n"
+    "damage_given INT,\n"
+    "damage_recvd INT,\n"
+    "PRIMARY KEY(player_id,day)\n"
+");\n"
+
+"CREATE TABLE IF NOT EXISTS frags_daily(\n"
+    "player_id INT,\n"
+    "day INT,\n"
+    "frag INT,\n"
+    "kills INT,\n"
+    "deaths INT,\n"
+    "suicides INT,\n"
+    "atts INT,\n"
+    "hits INT,\n"
+    "PRIMARY KEY(player_id,day,frag)\n"
+");\n"
+
+"CREATE TABLE IF NOT EXISTS items_daily(\n"
+    "player_id INT,\n"
+    "day INT,\n"
+    "item INT,\n"
+    "pickups INT,\n"
+    "misses INT,\n"
+    "kills INT,\n"
+    "PRIMARY KEY(player_id,day,item)\n"
+");\n"
+
+"CREATE TABLE IF NOT EXISTS player_totals(\n"
+    "player_id INTEGER PRIMARY KEY,\n"
+    "sessions INT,\n"
+    "time INT,\n"
+    "score INT,\n"
+    "deaths INT,\n"
+    "damage_given INT,\n"
+    "damage_recvd INT\n"
+");\n"
+
+"CREATE TABLE IF NOT EXISTS frag_totals(\n"
+    "player_id INT,\n"
+    "frag INT,\n"
+    "kills INT,\n"
+    "deaths INT,\n"
+    "suicides INT,\n"
+    "atts INT,\n"
+    "hits INT,\n"
+    "PRIMARY KEY(player_id,frag)\n"
+");\n"
+
+"CREATE TEMP TABLE IF NOT EXISTS rollup_batch(\n"
+    "id INTEGER PRIMARY KEY\n"
+");\n"
+
+"COMMIT;\n";
+
+// fills lifetime totals from existing rows when upgrading older databases
+static const char backfill[] =
+"BEGIN TRANSACTION;\n"
+
+"INSERT INTO player_totals "
+"SELECT player_id,SUM(n),SUM(time),SUM(score),SUM(deaths),"
+"SUM(damage_given),SUM(damage_recvd) FROM ("
+    "SELECT player_id,1 AS n,time,score,deaths,damage_given,damage_recvd "
+    "FROM records UNION ALL "
+    "SELECT player_id,sessions,time,score,deaths,damage_given,damage_recvd "
+    "FROM records_daily"
+") GROUP BY player_id;\n"
+
+"INSERT INTO frag_totals "
+"SELECT player_id,frag,SUM(kills),SUM(deaths),SUM(suicides),"
+"SUM(atts),SUM(hits) FROM ("
+    "SELECT player_id,frag,kills,deaths,suicides,atts,hits FROM frags UNION ALL "
+    "SELECT player_id,frag,kills,deaths,suicides,atts,hits FROM frags_daily"
+") GROUP BY player_id,frag;\n"
+
 "COMMIT;\n";
 
+/*
+==============================================================================
+
+QUERY WORKER
+
+Lifetime stats queries are answered by a worker thread with its own read-only
+connection, so that the game thread never waits for disk. Each client may
+have one query in flight, results are picked up by G_RunQueries.
+
+==============================================================================
+*/
+
+typedef enum {
+    QUERY_FREE,
+    QUERY_PENDING,
+    QUERY_RUNNING,
+    QUERY_DONE
+} query_state_t;
+
+typedef struct {
+    query_state_t   state;
+    char            requester[MAX_NETNAME];
+    char            name[MAX_NETNAME];
+    int             result;     // SQLITE_ROW if found, SQLITE_DONE if not
+    lifestats_t     stats;
+} dbquery_t;
+
+static dbquery_t    queries[MAX_CLIENTS];
+static int          numqueries;     // not in QUERY_FREE state
+static thread_t     worker;
+static mutex_t      worker_mutex;
+static cond_t       worker_cond;
+static qboolean     worker_running;
+static qboolean     worker_quit;
+
+static int worker_query( sqlite3 *wdb, const char *name, lifestats_t *s ) {
+    sqlite3_stmt *stmt;
+    sqlite3_int64 id;
+    fragstat_t *fs;
+    int ret, frag;
+
+    memset( s, 0, sizeof( *s ) );
+
+    ret = sqlite3_prepare_v2( wdb,
+        "SELECT t.player_id,t.sessions,t.time,t.score,t.deaths,"
+        "t.damage_given,t.damage_recvd "
+        "FROM players p JOIN player_totals t ON t.player_id=p.rowid "
+        "WHERE p.netname=?", -1, &stmt, NULL );
+    if( ret ) {
+        return ret;
+    }
+    sqlite3_bind_text( stmt, 1, name, -1, SQLITE_STATIC );
+    ret = sqlite3_step( stmt );
+    if( ret == SQLITE_ROW ) {
+        id = sqlite3_column_int64( stmt, 0 );
+        s->sessions = sqlite3_column_int( stmt, 1 );
+        s->time = sqlite3_column_int( stmt, 2 );
+        s->score = sqlite3_column_int( stmt, 3 );
+        s->deaths = sqlite3_column_int( stmt, 4 );
+        s->damage_given = sqlite3_column_int( stmt, 5 );
+        s->damage_recvd = sqlite3_column_int( stmt, 6 );
+    }
+    sqlite3_finalize( stmt );
+    if( ret != SQLITE_ROW ) {
+        return ret;
+    }
+
+    ret = sqlite3_prepare_v2( wdb,
+        "SELECT frag,kills,deaths,suicides,atts,hits "
+        "FROM frag_totals WHERE player_id=?", -1, &stmt, NULL );
+    if( ret ) {
+        return ret;
+    }
+    sqlite3_bind_int64( stmt, 1, id );
+    while( ( ret = sqlite3_step( stmt ) ) == SQLITE_ROW ) {
+        frag = sqlite3_column_int( stmt, 0 );
+        if( frag < 0 || frag >= FRAG_TOTAL ) {
+            continue;
+        }
+        fs = &s->frags[frag];
+        fs->kills = sqlite3_column_int( stmt, 1 );
+        fs->deaths = sqlite3_column_int( stmt, 2 );
+        fs->suicides = sqlite3_column_int( stmt, 3 );
+        fs->atts = sqlite3_column_int( stmt, 4 );
+        fs->hits = sqlite3_column_int( stmt, 5 );
+    }
+    sqlite3_finalize( stmt );
+
+    return ret == SQLITE_DONE ? SQLITE_ROW : ret;
+}
+
+static THREAD_FUNC worker_func( void *arg ) {
+    sqlite3 *wdb;
+    dbquery_t *q;
+    char name[MAX_NETNAME];
+    lifestats_t stats;
+    int i, ret, result;
+
+    ret = sqlite3_open_v2( db_path, &wdb, SQLITE_OPEN_READONLY, NULL );
+    if( ret == SQLITE_OK ) {
+        sqlite3_busy_timeout( wdb, 1000 );
+    }
+
+    mutex_lock( &worker_mutex );
+    while( !worker_quit ) {
+        for( i = 0, q = queries; i < MAX_CLIENTS; i++, q++ ) {
+            if( q->state == QUERY_PENDING ) {
+                break;
+            }
+        }
+        if( i == MAX_CLIENTS ) {
+            cond_wait( &worker_cond, &worker_mutex );
+            continue;
+        }
+
+        q->state = QUERY_RUNNING;
+        memcpy( name, q->name, sizeof( name ) );
+        mutex_unlock( &worker_mutex );
+
+        if( ret == SQLITE_OK ) {
+            result = worker_query( wdb, name, &stats );
+        } else {
+            result = ret;
+        }
+
+        mutex_lock( &worker_mutex );
+        q->result = result;
+        if( result == SQLITE_ROW ) {
+            q->stats = stats;
+        }
+        q->state = QUERY_DONE;
+    }
+    mutex_unlock( &worker_mutex );
+
+    sqlite3_close( wdb );
+    return THREAD_RETURN;
+}
+
+static void G_StartWorker( void ) {
+    if( !sqlite3_threadsafe() ) {
+        gi.dprintf( "SQLite library is not thread safe, lifetime stats disabled\n" );
+        return;
+    }
+
+    memset( queries, 0, sizeof( queries ) );
+    numqueries = 0;
+    worker_quit = qfalse;
+
+    mutex_init( &worker_mutex );
+    cond_init( &worker_cond );
+
+    if( !thread_create( &worker, worker_func ) ) {
+        gi.dprintf( "Couldn't create SQLite worker thread\n" );
+        cond_destroy( &worker_cond );
+        mutex_destroy( &worker_mutex );
+        return;
+    }
+
+    worker_running = qtrue;
+}
+
+static void G_StopWorker( void ) {
+    if( !worker_running ) {
+        return;
+    }
+
+    mutex_lock( &worker_mutex );
+    worker_quit = qtrue;
+    cond_signal( &worker_cond );
+    mutex_unlock( &worker_mutex );
+
+    thread_join( worker );
+
+    cond_destroy( &worker_cond );
+    mutex_destroy( &worker_mutex );
+
+    worker_running = qfalse;
+}
+
+/*
+==============
+G_QueryLifeStats
+
+Submits lifetime stats query for player `name' on behalf of `ent'.
+==============
+*/
+void G_QueryLifeStats( edict_t *ent, const char *name ) {
+    dbquery_t *q;
+
+    if( !worker_running ) {
+        gi.cprintf( ent, PRINT_HIGH, "Lifetime stats are not available on this server.\n" );
+        return;
+    }
+
+    q = &queries[ent->client - game.clients];
+
+    mutex_lock( &worker_mutex );
+    if( q->state != QUERY_FREE ) {
+        mutex_unlock( &worker_mutex );
+        gi.cprintf( ent, PRINT_HIGH, "Your previous query is still in progress.\n" );
+        return;
+    }
+    Q_strlcpy( q->requester, ent->client->pers.netname, sizeof( q->requester ) );
+    Q_strlcpy( q->name, name, sizeof( q->name ) );
+    q->state = QUERY_PENDING;
+    cond_signal( &worker_cond );
+    mutex_unlock( &worker_mutex );
+
+    numqueries++;
+}
+
+/*
+==============
+G_RunQueries
+
+Delivers completed queries to clients that are still around.
+==============
+*/
+void G_RunQueries( void ) {
+    gclient_t *c;
+    dbquery_t *q;
+    int i;
+
+    if( !numqueries ) {
+        return;
+    }
+
+    mutex_lock( &worker_mutex );
+    for( i = 0, q = queries; i < game.maxclients; i++, q++ ) {
+        if( q->state != QUERY_DONE ) {
+            continue;
+        }
+
+        // drop the answer if requester has left in the meantime
+        c = &game.clients[i];
+        if( c->pers.connected > CONN_CONNECTED &&
+            !strcmp( c->pers.netname, q->requester ) ) {
+            if( q->result == SQLITE_ROW ) {
+                G_PrintLifeStats( c->edict, q->name, &q->stats );
+            } else if( q->result == SQLITE_DONE ) {
+                gi.cprintf( c->edict, PRINT_HIGH,
+                    "No lifetime stats available for %s.\n", q->name );
+            } else {
+                gi.cprintf( c->edict, PRINT_HIGH,
+                    "Lifetime stats query failed: %s\n", sqlite3_errstr( q->result ) );
+            }
+        }
+
+        q->state = QUERY_FREE;
+        numqueries--;
+    }
+    mutex_unlock( &worker_mutex );
+}
+
 qboolean G_OpenDatabase( void ) {
     char buffer[MAX_OSPATH];
     size_t len;
     char *err;
     int ret;
+    qboolean upgrade;
 
     if( db ) {
         return qtrue;
@@ -237,6 +759,12 @@ qboolean G_OpenDatabase( void ) {
         goto fail;
     }
 
+    // allow the query worker to read while we are writing
+    ret = db_execute( "PRAGMA journal_mode=WAL" );
+    if( ret ) {
+        goto fail;
+    }
+
     if( (int)g_sql_async->value ) {
         ret = db_execute( "PRAGMA synchronous=OFF" );
         if( ret ) {
@@ -244,6 +772,13 @@ qboolean G_OpenDatabase( void ) {
         }
     }
 
+    numcols = 0;
+    ret = db_query( "SELECT rowid FROM sqlite_master WHERE name='player_totals'" );
+    if( ret ) {
+        goto fail;
+    }
+    upgrade = !numcols;
+
     ret = sqlite3_exec( db, schema, NULL, NULL, &err );
     if( ret ) {
         Com_EPrintf( "Couldn't create SQLite database schema: %s\n", err );
@@ -251,8 +786,20 @@ qboolean G_OpenDatabase( void ) {
         goto fail;
     }
 
+    if( upgrade ) {
+        ret = sqlite3_exec( db, backfill, NULL, NULL, &err );
+        if( ret ) {
+            Com_EPrintf( "Couldn't fill SQLite lifetime totals: %s\n", err );
+            sqlite3_free( err );
+            goto fail;
+        }
+    }
+
     gi.dprintf( "Logging to SQLite database '%s'\n", buffer );
 
+    Q_strlcpy( db_path, buffer, sizeof( db_path ) );
+    G_StartWorker();
+
     return qtrue;
 
 fail:
@@ -262,6 +809,10 @@ fail:
 }
 
 void G_CloseDatabase( void ) {
+    G_StopWorker();
+
+    rollup_current = q_countof( rollups );
+
     if( db ) {
         gi.dprintf( "Closing SQLite database\n" );
         sqlite3_close( db );
@@ -70,7 +70,7 @@ static void Svcmd_MapQueue_f(void)
         return;
     }
 
-    total = G_CalcRanks(NULL);
+    total = level.numranks;
 
     Com_Printf("map             min max\n"
                "--------------- --- ---\n");
@@ -126,6 +126,8 @@ void G_ServerCommand(void)
         Cmd_Stats_f(NULL, qtrue);
     else if (!strcmp(cmd, "settings") || !strcmp(cmd, "matchinfo"))
         Cmd_Settings_f(NULL);
+    else if (!strcmp(cmd, "cmdstats"))
+        G_CommandStats_f();
     else
         Com_Printf("Unknown server command \"%s\"\n", cmd);
 }
@@ -99,6 +99,44 @@ edict_t *findradius(edict_t *from, vec3_t org, float rad)
 }
 
 
+/*
+=================
+G_FindRadius
+
+Returns solid entities within a spherical radius, like findradius, but
+queries the world area links instead of walking all edicts.
+=================
+*/
+int G_FindRadius(vec3_t org, float rad, edict_t **list, int maxcount)
+{
+    vec3_t  mins, maxs, eorg;
+    edict_t *e;
+    int     i, j, num, count;
+
+    for (j = 0; j < 3; j++) {
+        mins[j] = org[j] - rad;
+        maxs[j] = org[j] + rad;
+    }
+
+    num = gi.BoxEdicts(mins, maxs, list, maxcount, AREA_SOLID);
+
+    for (i = count = 0; i < num; i++) {
+        e = list[i];
+        if (!e->inuse)
+            continue;
+        if (e->solid == SOLID_NOT)
+            continue;
+        for (j = 0; j < 3; j++)
+            eorg[j] = org[j] - (e->s.origin[j] + (e->mins[j] + e->maxs[j]) * 0.5);
+        if (VectorLength(eorg) > rad)
+            continue;
+        list[count++] = e;
+    }
+
+    return count;
+}
+
+
 /*
 =============
 G_PickTarget
@@ -361,6 +399,25 @@ void vectoangles(vec3_t value1, vec3_t angles)
     angles[ROLL] = 0;
 }
 
+/*
+=============
+G_HashString
+
+Case insensitive hash of the first len characters of string.
+Size must be a power of two.
+=============
+*/
+unsigned G_HashString(const char *s, size_t len, unsigned size)
+{
+    unsigned hash = 0;
+
+    while (len--) {
+        hash = hash * 31 + Q_tolower(*s++);
+    }
+
+    return hash & (size - 1);
+}
+
 char *G_CopyString(const char *in)
 {
     size_t  len;
@@ -395,23 +452,37 @@ angles and bad trails.
 */
 edict_t *G_Spawn(void)
 {
-    int         i;
     edict_t     *e;
 
-    e = &g_edicts[game.maxclients + 1];
-    for (i = game.maxclients + 1; i < globals.num_edicts; i++, e++) {
+    // freed edicts are queued in order of freetime, so only the oldest
+    // one needs to be checked
+    while (!LIST_EMPTY(&level.free_edicts)) {
+        e = LIST_FIRST(edict_t, &level.free_edicts, free_entry);
+        if (e->inuse || e - g_edicts >= globals.num_edicts) {
+            // stale entry after level reset
+            List_Remove(&e->free_entry);
+            memset(&e->free_entry, 0, sizeof(e->free_entry));
+            continue;
+        }
         // the first couple seconds of server time can involve a lot of
         // freeing and allocating, so relax the replacement policy
-        if (!e->inuse && (e->freetime < 2 || level.time - e->freetime > 0.5)) {
+        if (e->freetime < 2 || level.time - e->freetime > 0.5) {
+            List_Remove(&e->free_entry);
+            memset(&e->free_entry, 0, sizeof(e->free_entry));
             G_InitEdict(e);
             return e;
         }
+        break;
     }
 
-    if (i == game.maxentities)
+    if (globals.num_edicts == game.maxentities)
         gi.error("ED_Alloc: no free edicts");
 
-    globals.num_edicts++;
+    e = &g_edicts[globals.num_edicts++];
+    if (e->free_entry.next) {
+        List_Remove(&e->free_entry);
+        memset(&e->free_entry, 0, sizeof(e->free_entry));
+    }
     G_InitEdict(e);
     return e;
 }
@@ -432,10 +503,18 @@ void G_FreeEdict(edict_t *ed)
         return;
     }
 
+    if (ed->item_entry.next) {
+        List_Remove(&ed->item_entry);
+    }
+    if (ed->free_entry.next) {
+        List_Remove(&ed->free_entry);
+    }
+
     memset(ed, 0, sizeof(*ed));
     ed->classname = "freed";
     ed->freetime = level.time;
     ed->inuse = qfalse;
+    List_Append(&level.free_edicts, &ed->free_entry);
 }
 
 
@@ -23,40 +23,82 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define MAY_VOTE(c) \
     (c->pers.connected == CONN_SPAWNED || c->pers.admin || VF(SPECS))
 
-static int G_CalcVote(int *votes)
+/*
+==================
+G_UpdateVoter
+
+Updates vote tally after client has cast a vote, changed connection
+state or admin status. Votes are counted incrementally so that
+checking them does not need to scan all clients.
+==================
+*/
+void G_UpdateVoter(gclient_t *c)
 {
-    gclient_t *c;
-    int total = 0;
+    qboolean voter;
+    int *cast = NULL;
 
-    votes[0] = votes[1] = 0;
-    for (c = game.clients; c < game.clients + game.maxclients; c++) {
-        if (c->pers.connected <= CONN_CONNECTED) {
-            continue;
-        }
-        if (c->pers.mvdspec) {
-            continue;
+    // don't count spectators
+    voter = c->pers.connected > CONN_CONNECTED && !c->pers.mvdspec && MAY_VOTE(c);
+
+    if (voter && level.vote.proposal && c->level.vote.index == level.vote.index) {
+        cast = &level.vote.tally[!!c->pers.admin][c->level.vote.accepted];
+    }
+
+    if (c->level.vote.voter != voter) {
+        level.vote.voters += voter ? 1 : -1;
+        c->level.vote.voter = voter;
+        level.vote.changed = qtrue;
+    }
+
+    if (c->level.vote.cast != cast) {
+        if (c->level.vote.cast) {
+            (*c->level.vote.cast)--;
         }
-        if (!MAY_VOTE(c)) {
-            continue; // don't count spectators
+        if (cast) {
+            (*cast)++;
         }
+        c->level.vote.cast = cast;
+        level.vote.changed = qtrue;
+    }
+}
 
-        total++;
-        if (c->level.vote.index != level.vote.index) {
-            continue; // not voted yet
-        }
+/*
+==================
+G_RecountVotes
 
-        if (c->pers.admin) {
-            // admin vote decides immediately
-            votes[c->level.vote.accepted    ] = game.maxclients;
-            votes[c->level.vote.accepted ^ 1] = 0;
-            break;
-        }
+Rebuilds vote tally from scratch, needed when voting rules change.
+==================
+*/
+void G_RecountVotes(void)
+{
+    gclient_t *c;
 
+    level.vote.voters = 0;
+    memset(level.vote.tally, 0, sizeof(level.vote.tally));
+    for (c = game.clients; c < game.clients + game.maxclients; c++) {
+        c->level.vote.voter = qfalse;
+        c->level.vote.cast = NULL;
+        G_UpdateVoter(c);
+    }
+}
+
+static int G_CalcVote(int *votes)
+{
+    int *admin = level.vote.tally[1];
+    qboolean accepted;
+
+    if (admin[0] || admin[1]) {
+        // admin vote decides immediately
+        accepted = admin[1] > admin[0];
+        votes[accepted    ] = game.maxclients;
+        votes[accepted ^ 1] = 0;
+    } else {
         // count normal vote
-        votes[c->level.vote.accepted]++;
+        votes[0] = level.vote.tally[0][0];
+        votes[1] = level.vote.tally[0][1];
     }
 
-    return total;
+    return level.vote.voters;
 }
 
 static int _G_CalcVote(int *votes)
@@ -71,6 +113,14 @@ static int _G_CalcVote(int *votes)
 
 void G_FinishVote(void)
 {
+    gclient_t *c;
+
+    // casts are only counted while proposal is active
+    for (c = game.clients; c < game.clients + game.maxclients; c++) {
+        c->level.vote.cast = NULL;
+    }
+    memset(level.vote.tally, 0, sizeof(level.vote.tally));
+
     if (VF(SHOW)) {
         gi.configstring(CS_VOTE_PROPOSAL, "");
     }
@@ -96,15 +146,16 @@ void G_UpdateVote(void)
         return;
     }
 
-    // update vote count every second
     if (!VF(SHOW)) {
         return;
     }
 
+    // update vote count every second and when votes change
     remaining = level.vote.framenum - level.framenum;
-    if (remaining % HZ) {
+    if (remaining % HZ && !level.vote.changed) {
         return;
     }
+    level.vote.changed = qfalse;
 
     total = _G_CalcVote(votes);
     Q_snprintf(buffer, sizeof(buffer), "Yes: %d (%d) No: %d [%02d sec]",
@@ -322,6 +373,7 @@ void Cmd_CastVote_f(edict_t *ent, qboolean accepted)
 
     ent->client->level.vote.index = level.vote.index;
     ent->client->level.vote.accepted = accepted;
+    G_UpdateVoter(ent->client);
 
     if (G_CheckVote()) {
         return;
@@ -708,6 +760,7 @@ void Cmd_Vote_f(edict_t *ent)
     ent->client->level.vote.index = level.vote.index;
     ent->client->level.vote.accepted = qtrue;
     ent->client->level.vote.count++;
+    G_UpdateVoter(ent->client);
 
     // decide vote immediately
     if (!G_CheckVote()) {
@@ -21,125 +21,234 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 /*
 =================
-fire_lead
+lead helpers
 
-This is an internal support routine used for bullet/pellet based weapons.
+Support routines for fire_lead and fire_shotgun. Muzzle trace and aiming
+basis are computed once per shot and shared by all pellets.
 =================
 */
-static void fire_lead(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick, int te_impact, int hspread, int vspread, int mod)
+#define MAX_LEAD_EFFECTS    8       // per shot
+#define LEAD_EFFECT_DIST    16      // effects closer than this are merged
+#define MAX_LEAD_TARGETS    16      // damaged entities remembered per shot
+
+typedef struct {
+    int         count;
+    vec3_t      origins[MAX_LEAD_EFFECTS];
+} leadfx_t;
+
+typedef struct {
+    edict_t     *self;
+    float       *start;
+    trace_t     muzzle;             // from shooter origin to start
+    vec3_t      forward, right, up;
+    int         content_mask;
+    qboolean    start_water;
+    leadfx_t    impacts, splashes;  // only used by shotgun
+} lead_t;
+
+typedef struct {
+    edict_t     *ent;
+    int         count;              // number of pellets
+    vec3_t      point, normal;      // where the first pellet hit
+} leadhit_t;
+
+// returns qfalse if similar effect was already sent for this shot
+static qboolean lead_effect(leadfx_t *fx, vec3_t origin)
+{
+    vec3_t v;
+    int i;
+
+    if (!fx) {
+        return qtrue;
+    }
+
+    for (i = 0; i < fx->count; i++) {
+        VectorSubtract(origin, fx->origins[i], v);
+        if (VectorLength(v) < LEAD_EFFECT_DIST) {
+            return qfalse;
+        }
+    }
+
+    if (fx->count == MAX_LEAD_EFFECTS) {
+        return qfalse;
+    }
+
+    VectorCopy(origin, fx->origins[fx->count]);
+    fx->count++;
+    return qtrue;
+}
+
+static void lead_begin(lead_t *l, edict_t *self, vec3_t start, vec3_t aimdir)
+{
+    vec3_t dir;
+
+    l->self = self;
+    l->start = start;
+    l->muzzle = gi.trace(self->s.origin, NULL, NULL, start, self, MASK_SHOT);
+    l->content_mask = MASK_SHOT | MASK_WATER;
+    l->start_water = qfalse;
+    l->impacts.count = 0;
+    l->splashes.count = 0;
+
+    if (l->muzzle.fraction < 1.0) {
+        return;
+    }
+
+    vectoangles(aimdir, dir);
+    AngleVectors(dir, l->forward, l->right, l->up);
+
+    if (gi.pointcontents(start) & MASK_WATER) {
+        l->start_water = qtrue;
+        l->content_mask &= ~MASK_WATER;
+    }
+}
+
+// returns qtrue if went through water
+static qboolean lead_trace(lead_t *l, leadfx_t *splashes, trace_t *tr, vec3_t water_start, int hspread, int vspread)
 {
-    trace_t     tr;
     vec3_t      dir;
     vec3_t      forward, right, up;
     vec3_t      end;
     float       r;
     float       u;
-    vec3_t      water_start;
-    qboolean    water = qfalse;
-    int         content_mask = MASK_SHOT | MASK_WATER;
+    float       *start = l->start;
+    qboolean    water = l->start_water;
 
-    tr = gi.trace(self->s.origin, NULL, NULL, start, self, MASK_SHOT);
-    if (!(tr.fraction < 1.0)) {
-        vectoangles(aimdir, dir);
-        AngleVectors(dir, forward, right, up);
+    if (l->muzzle.fraction < 1.0) {
+        *tr = l->muzzle;
+        return qfalse;
+    }
 
-        r = crandom() * hspread;
-        u = crandom() * vspread;
-        VectorMA(start, 8192, forward, end);
-        VectorMA(end, r, right, end);
-        VectorMA(end, u, up, end);
+    r = crandom() * hspread;
+    u = crandom() * vspread;
+    VectorMA(start, 8192, l->forward, end);
+    VectorMA(end, r, l->right, end);
+    VectorMA(end, u, l->up, end);
 
-        if (gi.pointcontents(start) & MASK_WATER) {
-            water = qtrue;
-            VectorCopy(start, water_start);
-            content_mask &= ~MASK_WATER;
-        }
+    if (water) {
+        VectorCopy(start, water_start);
+    }
 
-        tr = gi.trace(start, NULL, NULL, end, self, content_mask);
+    *tr = gi.trace(start, NULL, NULL, end, l->self, l->content_mask);
 
-        // see if we hit water
-        if (tr.contents & MASK_WATER) {
-            int     color;
+    // see if we hit water
+    if (tr->contents & MASK_WATER) {
+        int     color;
 
-            water = qtrue;
-            VectorCopy(tr.endpos, water_start);
-
-            if (!VectorCompare(start, tr.endpos)) {
-                if (tr.contents & CONTENTS_WATER) {
-                    if (strcmp(tr.surface->name, "*brwater") == 0)
-                        color = SPLASH_BROWN_WATER;
-                    else
-                        color = SPLASH_BLUE_WATER;
-                } else if (tr.contents & CONTENTS_SLIME)
-                    color = SPLASH_SLIME;
-                else if (tr.contents & CONTENTS_LAVA)
-                    color = SPLASH_LAVA;
+        water = qtrue;
+        VectorCopy(tr->endpos, water_start);
+
+        if (!VectorCompare(start, tr->endpos)) {
+            if (tr->contents & CONTENTS_WATER) {
+                if (strcmp(tr->surface->name, "*brwater") == 0)
+                    color = SPLASH_BROWN_WATER;
                 else
-                    color = SPLASH_UNKNOWN;
-
-                if (color != SPLASH_UNKNOWN) {
-                    gi.WriteByte(svc_temp_entity);
-                    gi.WriteByte(TE_SPLASH);
-                    gi.WriteByte(8);
-                    gi.WritePosition(tr.endpos);
-                    gi.WriteDir(tr.plane.normal);
-                    gi.WriteByte(color);
-                    gi.multicast(tr.endpos, MULTICAST_PVS);
-                }
+                    color = SPLASH_BLUE_WATER;
+            } else if (tr->contents & CONTENTS_SLIME)
+                color = SPLASH_SLIME;
+            else if (tr->contents & CONTENTS_LAVA)
+                color = SPLASH_LAVA;
+            else
+                color = SPLASH_UNKNOWN;
 
-                // change bullet's course when it enters water
-                VectorSubtract(end, start, dir);
-                vectoangles(dir, dir);
-                AngleVectors(dir, forward, right, up);
-                r = crandom() * hspread * 2;
-                u = crandom() * vspread * 2;
-                VectorMA(water_start, 8192, forward, end);
-                VectorMA(end, r, right, end);
-                VectorMA(end, u, up, end);
+            if (color != SPLASH_UNKNOWN && lead_effect(splashes, tr->endpos)) {
+                gi.WriteByte(svc_temp_entity);
+                gi.WriteByte(TE_SPLASH);
+                gi.WriteByte(8);
+                gi.WritePosition(tr->endpos);
+                gi.WriteDir(tr->plane.normal);
+                gi.WriteByte(color);
+                gi.multicast(tr->endpos, MULTICAST_PVS);
             }
 
-            // re-trace ignoring water this time
-            tr = gi.trace(water_start, NULL, NULL, end, self, MASK_SHOT);
+            // change bullet's course when it enters water
+            VectorSubtract(end, start, dir);
+            vectoangles(dir, dir);
+            AngleVectors(dir, forward, right, up);
+            r = crandom() * hspread * 2;
+            u = crandom() * vspread * 2;
+            VectorMA(water_start, 8192, forward, end);
+            VectorMA(end, r, right, end);
+            VectorMA(end, u, up, end);
         }
+
+        // re-trace ignoring water this time
+        *tr = gi.trace(water_start, NULL, NULL, end, l->self, MASK_SHOT);
     }
 
+    return water;
+}
+
+// returns qtrue if trace hit something that can take damage
+static qboolean lead_impact(trace_t *tr, leadfx_t *impacts, int te_impact)
+{
     // send gun puff / flash
-    if (!((tr.surface) && (tr.surface->flags & SURF_SKY))) {
-        if (tr.fraction < 1.0) {
-            if (tr.ent->takedamage) {
-                T_Damage(tr.ent, self, self, aimdir, tr.endpos, tr.plane.normal, damage, kick, DAMAGE_BULLET, mod);
-            } else {
-                if (strncmp(tr.surface->name, "sky", 3) != 0) {
-                    gi.WriteByte(svc_temp_entity);
-                    gi.WriteByte(te_impact);
-                    gi.WritePosition(tr.endpos);
-                    gi.WriteDir(tr.plane.normal);
-                    gi.multicast(tr.endpos, MULTICAST_PVS);
-                }
-            }
-        }
+    if ((tr->surface) && (tr->surface->flags & SURF_SKY)) {
+        return qfalse;
+    }
+    if (!(tr->fraction < 1.0)) {
+        return qfalse;
+    }
+    if (tr->ent->takedamage) {
+        return qtrue;
     }
+    if (strncmp(tr->surface->name, "sky", 3) != 0 && lead_effect(impacts, tr->endpos)) {
+        gi.WriteByte(svc_temp_entity);
+        gi.WriteByte(te_impact);
+        gi.WritePosition(tr->endpos);
+        gi.WriteDir(tr->plane.normal);
+        gi.multicast(tr->endpos, MULTICAST_PVS);
+    }
+    return qfalse;
+}
 
-    // if went through water, determine where the end and make a bubble trail
-    if (water) {
-        vec3_t  pos;
+// if went through water, determine where the end and make a bubble trail
+static void lead_bubbles(trace_t *tr, vec3_t water_start)
+{
+    vec3_t  dir, pos;
 
-        VectorSubtract(tr.endpos, water_start, dir);
-        VectorNormalize(dir);
-        VectorMA(tr.endpos, -2, dir, pos);
-        if (gi.pointcontents(pos) & MASK_WATER)
-            VectorCopy(pos, tr.endpos);
-        else
-            tr = gi.trace(pos, NULL, NULL, water_start, tr.ent, MASK_WATER);
+    VectorSubtract(tr->endpos, water_start, dir);
+    VectorNormalize(dir);
+    VectorMA(tr->endpos, -2, dir, pos);
+    if (gi.pointcontents(pos) & MASK_WATER)
+        VectorCopy(pos, tr->endpos);
+    else
+        *tr = gi.trace(pos, NULL, NULL, water_start, tr->ent, MASK_WATER);
 
-        VectorAdd(water_start, tr.endpos, pos);
-        VectorScale(pos, 0.5, pos);
+    VectorAdd(water_start, tr->endpos, pos);
+    VectorScale(pos, 0.5, pos);
 
-        gi.WriteByte(svc_temp_entity);
-        gi.WriteByte(TE_BUBBLETRAIL);
-        gi.WritePosition(water_start);
-        gi.WritePosition(tr.endpos);
-        gi.multicast(pos, MULTICAST_PVS);
+    gi.WriteByte(svc_temp_entity);
+    gi.WriteByte(TE_BUBBLETRAIL);
+    gi.WritePosition(water_start);
+    gi.WritePosition(tr->endpos);
+    gi.multicast(pos, MULTICAST_PVS);
+}
+
+/*
+=================
+fire_lead
+
+This is an internal support routine used for bullet/pellet based weapons.
+=================
+*/
+static void fire_lead(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick, int te_impact, int hspread, int vspread, int mod)
+{
+    lead_t      l;
+    trace_t     tr;
+    vec3_t      water_start;
+    qboolean    water;
+
+    lead_begin(&l, self, start, aimdir);
+
+    water = lead_trace(&l, NULL, &tr, water_start, hspread, vspread);
+
+    if (lead_impact(&tr, NULL, te_impact)) {
+        T_Damage(tr.ent, self, self, aimdir, tr.endpos, tr.plane.normal, damage, kick, DAMAGE_BULLET, mod);
+    }
+
+    if (water) {
+        lead_bubbles(&tr, water_start);
     }
 }
 
@@ -163,14 +272,57 @@ void fire_bullet(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kic
 fire_shotgun
 
 Shoots shotgun pellets.  Used by shotgun and super shotgun.
+
+All pellets are traced first. Nearby impact effects are merged, and each
+entity hit takes the damage of all its pellets in a single T_Damage.
 =================
 */
 void fire_shotgun(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick, int hspread, int vspread, int count, int mod)
 {
-    int     i;
+    lead_t      l;
+    trace_t     tr;
+    vec3_t      water_start;
+    qboolean    water;
+    leadhit_t   hits[MAX_LEAD_TARGETS], *hit;
+    int         i, numhits = 0;
+
+    lead_begin(&l, self, start, aimdir);
+
+    for (i = 0; i < count; i++) {
+        water = lead_trace(&l, &l.splashes, &tr, water_start, hspread, vspread);
+
+        if (lead_impact(&tr, &l.impacts, TE_SHOTGUN)) {
+            for (hit = hits; hit < hits + numhits; hit++) {
+                if (hit->ent == tr.ent) {
+                    break;
+                }
+            }
+            if (hit < hits + numhits) {
+                hit->count++;
+            } else if (numhits < MAX_LEAD_TARGETS) {
+                hit->ent = tr.ent;
+                hit->count = 1;
+                VectorCopy(tr.endpos, hit->point);
+                VectorCopy(tr.plane.normal, hit->normal);
+                numhits++;
+            } else {
+                T_Damage(tr.ent, self, self, aimdir, tr.endpos, tr.plane.normal, damage, kick, DAMAGE_BULLET, mod);
+            }
+        }
 
-    for (i = 0; i < count; i++)
-        fire_lead(self, start, aimdir, damage, kick, TE_SHOTGUN, hspread, vspread, mod);
+        if (water) {
+            lead_bubbles(&tr, water_start);
+        }
+    }
+
+    for (hit = hits; hit < hits + numhits; hit++) {
+        // earlier damage may have removed this entity
+        if (!hit->ent->inuse || !hit->ent->takedamage) {
+            continue;
+        }
+        T_Damage(hit->ent, self, self, aimdir, hit->point, hit->normal,
+                 damage * hit->count, kick * hit->count, DAMAGE_BULLET, mod);
+    }
 }
 
 
@@ -508,6 +660,13 @@ void fire_rocket(edict_t *self, vec3_t start, vec3_t dir, int damage, int speed,
 fire_rail
 =================
 */
+#define MAX_RAIL_TRACES     100
+
+typedef struct {
+    edict_t     *ent;
+    vec3_t      point, normal;
+} railhit_t;
+
 void fire_rail(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick)
 {
     vec3_t      from;
@@ -516,14 +675,16 @@ void fire_rail(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick)
     edict_t     *ignore;
     int         mask;
     qboolean    water;
-    int i;
+    railhit_t   hits[MAX_RAIL_TRACES], *hit;
+    int         i, numhits;
 
     VectorMA(start, 8192, aimdir, end);
     VectorCopy(start, from);
     ignore = self;
     water = qfalse;
     mask = MASK_SHOT | CONTENTS_SLIME | CONTENTS_LAVA;
-    for (i = 0; i < 100; i++) {
+    numhits = 0;
+    for (i = 0; i < MAX_RAIL_TRACES; i++) {
         tr = gi.trace(from, NULL, NULL, end, ignore, mask);
 
         if (tr.contents & (CONTENTS_SLIME | CONTENTS_LAVA)) {
@@ -537,10 +698,12 @@ void fire_rail(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick)
             else
                 ignore = NULL;
 
+            // remember what to hurt once the whole path is known
             if ((tr.ent != self) && (tr.ent->takedamage)) {
-                G_BeginDamage();
-                T_Damage(tr.ent, self, self, aimdir, tr.endpos, tr.plane.normal, damage, kick, 0, MOD_RAILGUN);
-                G_EndDamage();
+                hit = &hits[numhits++];
+                hit->ent = tr.ent;
+                VectorCopy(tr.endpos, hit->point);
+                VectorCopy(tr.plane.normal, hit->normal);
             }
         }
 
@@ -550,6 +713,17 @@ void fire_rail(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick)
         }
     }
 
+    // railgun hits are counted individually even within one batch
+    G_BeginDamage();
+    for (i = 0, hit = hits; i < numhits; i++, hit++) {
+        // earlier damage may have removed this entity
+        if (!hit->ent->inuse || !hit->ent->takedamage) {
+            continue;
+        }
+        T_Damage(hit->ent, self, self, aimdir, hit->point, hit->normal, damage, kick, 0, MOD_RAILGUN);
+    }
+    G_EndDamage();
+
     // send gun puff / flash
     gi.WriteByte(svc_temp_entity);
     gi.WriteByte(TE_RAILTRAIL);
@@ -648,21 +822,31 @@ void bfg_touch(edict_t *self, edict_t *other, cplane_t *plane, csurface_t *surf)
 }
 
 
+#define BFG_MAX_TARGETS     64
+#define BFG_MAX_TRACES      32      // per ball per frame
+
 void bfg_think(edict_t *self)
 {
     edict_t *ent;
     edict_t *ignore;
+    edict_t *list[BFG_MAX_TARGETS];
     vec3_t  point;
     vec3_t  dir;
     vec3_t  start;
     vec3_t  end;
+    vec3_t  lasers[BFG_MAX_TRACES];
     int     dmg;
+    int     i, num, numlasers, traces;
     trace_t tr;
 
     dmg = 5;
 
-    ent = NULL;
-    while ((ent = findradius(ent, self->s.origin, 256)) != NULL) {
+    num = G_FindRadius(self->s.origin, 256, list, BFG_MAX_TARGETS);
+    numlasers = traces = 0;
+
+    for (i = 0; i < num && traces < BFG_MAX_TRACES; i++) {
+        ent = list[i];
+
         if (ent == self)
             continue;
 
@@ -683,8 +867,9 @@ void bfg_think(edict_t *self)
         ignore = self;
         VectorCopy(self->s.origin, start);
         VectorMA(start, 2048, dir, end);
-        while (1) {
+        do {
             tr = gi.trace(start, NULL, NULL, end, ignore, CONTENTS_SOLID | CONTENTS_MONSTER | CONTENTS_DEADMONSTER);
+            traces++;
 
             if (!tr.ent)
                 break;
@@ -707,12 +892,20 @@ void bfg_think(edict_t *self)
 
             ignore = tr.ent;
             VectorCopy(tr.endpos, start);
-        }
+        } while (traces < BFG_MAX_TRACES);
 
-        gi.WriteByte(svc_temp_entity);
-        gi.WriteByte(TE_BFG_LASER);
-        gi.WritePosition(self->s.origin);
-        gi.WritePosition(tr.endpos);
+        VectorCopy(tr.endpos, lasers[numlasers]);
+        numlasers++;
+    }
+
+    // all lasers start at the ball, so they can share one multicast
+    if (numlasers) {
+        for (i = 0; i < numlasers; i++) {
+            gi.WriteByte(svc_temp_entity);
+            gi.WriteByte(TE_BFG_LASER);
+            gi.WritePosition(self->s.origin);
+            gi.WritePosition(lasers[i]);
+        }
         gi.multicast(self->s.origin, MULTICAST_PHS);
     }
 
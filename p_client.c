@@ -67,40 +67,64 @@ void player_pain(edict_t *self, edict_t *other, float kick, int damage)
 }
 
 
+/*
+==================
+G_UpdateRanks
+
+Updates rank and delta HUD strings. Strings are regenerated only for
+clients whose rank, number of players or delta from the leader have
+changed since the last update.
+==================
+*/
 int G_UpdateRanks(void)
 {
-    gclient_t   *ranks[MAX_CLIENTS];
+    gclient_t   **ranks = level.ranks;
     gclient_t   *c;
     char buffer[MAX_QPATH];
-    int i, j, total, topscore;
+    int i, j, total, topscore, delta;
 
-    total = G_CalcRanks(ranks);
+    total = level.numranks;
     if (!total) {
         return 0;
     }
 
-    // top player
-    c = ranks[0];
-    topscore = c->resp.score;
-    j = total > 1 ? ranks[1]->resp.score : 0;
-    Q_snprintf(buffer, sizeof(buffer), "  +%2d", topscore - j);
-    G_PrivateString(c->edict, PCS_DELTA, buffer);
-    Q_snprintf(buffer, sizeof(buffer), "1/%d", total);
-    G_PrivateString(c->edict, PCS_RANK, va("%5s", buffer));
-
-    UpdateChaseTargets(CHASE_LEADER, c->edict);
+    topscore = ranks[0]->resp.score;
 
-    // other players
-    for (i = 1; i < total; i++) {
+    for (i = 0; i < total; i++) {
         c = ranks[i];
-        Q_snprintf(buffer, sizeof(buffer), "  -%2d",
-                   topscore - c->resp.score);
-        for (j = 0; buffer[j]; j++) {
-            buffer[j] |= 128;
+
+        // retarget leader chasecams only when leader changes
+        if (i == 0 && c->level.hud_rank != 1) {
+            UpdateChaseTargets(CHASE_LEADER, c->edict);
+        }
+
+        // top player shows the lead over the next player
+        if (i == 0) {
+            delta = topscore - (total > 1 ? ranks[1]->resp.score : 0);
+        } else {
+            delta = topscore - c->resp.score;
+        }
+
+        if (c->level.hud_rank != i + 1 || c->level.hud_delta != delta) {
+            if (i == 0) {
+                Q_snprintf(buffer, sizeof(buffer), "  +%2d", delta);
+            } else {
+                Q_snprintf(buffer, sizeof(buffer), "  -%2d", delta);
+                for (j = 0; buffer[j]; j++) {
+                    buffer[j] |= 128;
+                }
+            }
+            G_PrivateString(c->edict, PCS_DELTA, buffer);
+            c->level.hud_delta = delta;
+        }
+
+        if (c->level.hud_rank != i + 1 || c->level.hud_total != total) {
+            Q_snprintf(buffer, sizeof(buffer), "%d/%d", i + 1, total);
+            G_PrivateString(c->edict, PCS_RANK, va("%5s", buffer));
+            c->level.hud_total = total;
         }
-        G_PrivateString(c->edict, PCS_DELTA, buffer);
-        Q_snprintf(buffer, sizeof(buffer), "%d/%d", i + 1, total);
-        G_PrivateString(c->edict, PCS_RANK, va("%5s", buffer));
+
+        c->level.hud_rank = i + 1;
     }
 
     return total;
@@ -111,6 +135,8 @@ void G_ScoreChanged(edict_t *ent)
     char buffer[MAX_QPATH];
     int total;
 
+    G_SortRank(ent->client);
+
     total = (int)fraglimit->value;
     if (total > 0) {
         Q_snprintf(buffer, sizeof(buffer), "%2d/%-2d",
@@ -517,6 +543,7 @@ static void ClientObituary(edict_t *self, edict_t *inflictor, edict_t *attacker)
                 self->client->resp.deaths++;
                 self->client->resp.frags[frag].deaths++;
                 AccountItemKills(attacker);
+                G_SortRank(self->client);
             }
             G_ScoreChanged(attacker);
             G_UpdateRanks();
@@ -1166,6 +1193,8 @@ void spectator_respawn(edict_t *ent, int connected)
     int total;
 
     ent->client->pers.connected = connected;
+    G_UpdateVoter(ent->client);
+    G_SortRank(ent->client);
     total = G_UpdateRanks();
 
     // notify others
@@ -1176,6 +1205,7 @@ void spectator_respawn(edict_t *ent, int connected)
         PutClientInServer(ent);
 
         G_ScoreChanged(ent);
+        G_BeginItemStats(ent->client);
 
         // add a teleportation effect
         ent->s.event = EV_PLAYER_TELEPORT;
@@ -1263,6 +1293,9 @@ void PutClientInServer(edict_t *ent)
 
     PMenu_Close(ent);
 
+    // chasecam is stopped by clearing chase_target below
+    List_Delete(&client->level.chase_entry);
+
     // deathmatch wipes most client data every spawn
     resp = client->resp;
     pers = client->pers;
@@ -1435,6 +1468,7 @@ void ClientBegin(edict_t *ent)
 
     ent->client->pers.connected = (level.intermission_framenum ||
                                    ent->client->pers.mvdspec) ? CONN_SPECTATOR : CONN_PREGAME;
+    G_UpdateVoter(ent->client);
 
     // locate ent at a spawn point
     PutClientInServer(ent);
@@ -1651,6 +1685,12 @@ void ClientUserinfoChanged(edict_t *ent, char *userinfo)
     // flags
     s = Info_ValueForKey(userinfo, "uf");
     client->pers.uf = *s ? atoi(s) : UF_LOCALFOV;
+
+    // message level, parsed the same way server does
+    s = Info_ValueForKey(userinfo, "msg");
+    if (*s) {
+        client->pers.msglevel = atoi(s);
+    }
 }
 
 
@@ -1687,6 +1727,8 @@ qboolean ClientConnect(edict_t *ent, char *userinfo)
 
     memset(ent->client, 0, sizeof(gclient_t));
     ent->client->edict = ent;
+    List_Init(&ent->client->level.chasers);
+    List_Init(&ent->client->level.chase_entry);
     ent->client->pers.connected = CONN_CONNECTED;
     ent->client->level.first_time = qtrue;
     ent->client->pers.loopback = !strcmp(s, "loopback");
@@ -1724,7 +1766,10 @@ void ClientDisconnect(edict_t *ent)
 
     connected = ent->client->pers.connected;
     ent->client->pers.connected = CONN_DISCONNECTED;
+    G_UpdateVoter(ent->client);
     ent->client->ps.stats[STAT_FRAGS] = 0;
+    G_SortRank(ent->client);
+    ChaseDisconnect(ent);
 
 #if USE_SQLITE
     if (connected == CONN_SPAWNED) {
@@ -47,26 +47,56 @@ static int G_PlayerCmp(const void *p1, const void *p2)
     return 0;
 }
 
-int G_CalcRanks(gclient_t **ranks)
+/*
+==================
+G_SortRank
+
+Keeps level.ranks sorted by score, then by deaths. Must be called each time
+client enters or leaves the game, or when its score or deaths change. Only
+this client can be out of place, so it is simply moved up or down.
+==================
+*/
+void G_SortRank(gclient_t *c)
 {
-    int i, total;
+    gclient_t **ranks = level.ranks;
+    int i = c->level.rank - 1;
 
-    // sort the clients by score, then by eff
-    total = 0;
-    for (i = 0; i < game.maxclients; i++) {
-        if (game.clients[i].pers.connected == CONN_SPAWNED) {
-            if (ranks) {
-                ranks[total] = &game.clients[i];
-            }
-            total++;
+    if (c->pers.connected != CONN_SPAWNED) {
+        if (i < 0) {
+            return;
         }
+        // remove from the list
+        for (level.numranks--; i < level.numranks; i++) {
+            ranks[i] = ranks[i + 1];
+            ranks[i]->level.rank = i + 1;
+        }
+        c->level.rank = 0;
+        c->level.hud_rank = 0;
+        level.scoreboard.dirty = qtrue;
+        return;
     }
 
-    if (ranks) {
-        qsort(ranks, total, sizeof(gclient_t *), G_PlayerCmp);
+    if (i < 0) {
+        // add to the bottom of the list
+        i = level.numranks++;
     }
 
-    return total;
+    while (i > 0 && G_PlayerCmp(&c, &ranks[i - 1]) < 0) {
+        ranks[i] = ranks[i - 1];
+        ranks[i]->level.rank = i + 1;
+        i--;
+    }
+
+    while (i < level.numranks - 1 && G_PlayerCmp(&c, &ranks[i + 1]) > 0) {
+        ranks[i] = ranks[i + 1];
+        ranks[i]->level.rank = i + 1;
+        i++;
+    }
+
+    ranks[i] = c;
+    c->level.rank = i + 1;
+
+    level.scoreboard.dirty = qtrue;
 }
 
 
@@ -74,28 +104,25 @@ int G_CalcRanks(gclient_t **ranks)
 ==================
 BuildDeathmatchScoreboard
 
-Used to update per-client scoreboard and build
-global oldscores (client is NULL in the latter case).
+Used to build shared scoreboard layout and global oldscores. All rows are
+added with 'string2' command. If rows is not NULL, offset of the '2' in each
+client's row is stored there (0 if client is not listed).
 ==================
 */
-static size_t BuildDeathmatchScoreboard(char *buffer, gclient_t *client)
+static size_t BuildDeathmatchScoreboard(char *buffer, const char *header, short *rows)
 {
     char    entry[MAX_STRING_CHARS];
     char    status[MAX_QPATH];
     char    timebuf[16];
     size_t  total, len;
-    int     i, j, numranks;
+    int     i, j;
     int     y, sec, eff;
-    gclient_t   *ranks[MAX_CLIENTS];
     gclient_t   *c;
     time_t      t;
     struct tm   *tm;
 
-    if (!client) {
-        Q_snprintf(entry, sizeof(entry),
-                   "yv 10 cstring2 \"Old scoreboard from %s\"", level.mapname);
-    } else {
-        entry[0] = 0;
+    if (rows) {
+        memset(rows, 0, sizeof(rows[0]) * MAX_CLIENTS);
     }
 
     t = time(NULL);
@@ -111,14 +138,12 @@ static size_t BuildDeathmatchScoreboard(char *buffer, gclient_t *client)
                         "xv -16 "
                         "yv 26 "
                         "string \"Player          Frg Dth Eff%% FPH Time Ping\""
-                        "xv -40 ", entry, status);
-
-    numranks = G_CalcRanks(ranks);
+                        "xv -40 ", header, status);
 
     // add the clients sorted by rank
     y = 34;
-    for (i = 0; i < numranks; i++) {
-        c = ranks[i];
+    for (i = 0; i < level.numranks; i++) {
+        c = level.ranks[i];
 
         sec = (level.framenum - c->resp.enter_framenum) / HZ;
         if (!sec) {
@@ -139,8 +164,8 @@ static size_t BuildDeathmatchScoreboard(char *buffer, gclient_t *client)
         }
 
         len = Q_snprintf(entry, sizeof(entry),
-                         "yv %d string%s \"%2d %-15s %3d %3d %3d %4d %4s %4d\"",
-                         y, c == client ? "" : "2", i + 1,
+                         "yv %d string2 \"%2d %-15s %3d %3d %3d %4d %4s %4d\"",
+                         y, i + 1,
                          c->pers.netname, c->resp.score, c->resp.deaths, eff,
                          c->resp.score * 3600 / sec, timebuf, c->ping);
         if (len >= sizeof(entry)) {
@@ -148,6 +173,9 @@ static size_t BuildDeathmatchScoreboard(char *buffer, gclient_t *client)
         }
         if (total + len >= MAX_STRING_CHARS)
             break;
+        if (rows) {
+            rows[c - game.clients] = total + strstr(entry, "string2") - entry + 6;
+        }
         memcpy(buffer + total, entry, len);
         total += len;
         y += 8;
@@ -176,14 +204,16 @@ static size_t BuildDeathmatchScoreboard(char *buffer, gclient_t *client)
         }
 
         len = Q_snprintf(entry, sizeof(entry),
-                         "yv %d string%s \"   %-15s %-18s%3d %4d\"",
-                         y, c == client ? "" : "2",
-                         c->pers.netname, status, sec / 60, c->ping);
+                         "yv %d string2 \"   %-15s %-18s%3d %4d\"",
+                         y, c->pers.netname, status, sec / 60, c->ping);
         if (len >= sizeof(entry)) {
             continue;
         }
         if (total + len >= MAX_STRING_CHARS)
             break;
+        if (rows) {
+            rows[c - game.clients] = total + strstr(entry, "string2") - entry + 6;
+        }
         memcpy(buffer + total, entry, len);
         total += len;
         y += 8;
@@ -258,6 +288,47 @@ void HighScoresMessage(void)
     gi.WriteByte(svc_layout);
     gi.WriteString(string);
     gi.multicast(NULL, MULTICAST_ALL_R);
+
+    // scoreboard needs to be sent again
+    for (i = 0; i < game.maxclients; i++) {
+        game.clients[i].level.scoreboard = 0;
+    }
+}
+
+/*
+==================
+G_UpdateScoreboard
+
+Rebuilds shared scoreboard layout at most once per frame, unless ranks have
+changed in between. Version is bumped only if the layout actually differs.
+==================
+*/
+static void G_UpdateScoreboard(void)
+{
+    char    buffer[MAX_STRING_CHARS];
+    short   rows[MAX_CLIENTS];
+    size_t  len;
+
+    if (level.scoreboard.version && !level.scoreboard.dirty &&
+        level.scoreboard.framenum == level.framenum) {
+        return;
+    }
+
+    len = BuildDeathmatchScoreboard(buffer, "", rows);
+
+    level.scoreboard.framenum = level.framenum;
+    level.scoreboard.dirty = qfalse;
+
+    if (level.scoreboard.version && len == level.scoreboard.length &&
+        !memcmp(buffer, level.scoreboard.layout, len) &&
+        !memcmp(rows, level.scoreboard.rows, sizeof(rows))) {
+        return;
+    }
+
+    memcpy(level.scoreboard.layout, buffer, len + 1);
+    memcpy(level.scoreboard.rows, rows, sizeof(rows));
+    level.scoreboard.length = len;
+    level.scoreboard.version++;
 }
 
 /*
@@ -265,18 +336,39 @@ void HighScoresMessage(void)
 DeathmatchScoreboardMessage
 
 Can go either as reliable message (manual updates, intermission)
-and unreliable (automatic). Note that it isn't that hard to overflow
+and unreliable (automatic). Unreliable message is not sent if client
+already has the current layout. Note that it isn't that hard to overflow
 the 1024 chars layout size limit!
 ==================
 */
 void DeathmatchScoreboardMessage(edict_t *ent, qboolean reliable)
 {
+    gclient_t *client = ent->client;
     char buffer[MAX_STRING_CHARS];
+    size_t len;
+    int row;
 
-    BuildDeathmatchScoreboard(buffer, ent->client);
+    G_UpdateScoreboard();
+
+    if (!reliable && client->level.scoreboard == level.scoreboard.version) {
+        return;
+    }
+
+    client->level.scoreboard = level.scoreboard.version;
 
     gi.WriteByte(svc_layout);
-    gi.WriteString(buffer);
+
+    row = level.scoreboard.rows[client - game.clients];
+    if (row) {
+        // highlight own row by turning 'string2' into 'string'
+        len = level.scoreboard.length;
+        memcpy(buffer, level.scoreboard.layout, row);
+        memcpy(buffer + row, level.scoreboard.layout + row + 1, len - row);
+        gi.WriteString(buffer);
+    } else {
+        gi.WriteString(level.scoreboard.layout);
+    }
+
     gi.unicast(ent, reliable);
 }
 
@@ -363,7 +455,13 @@ void BeginIntermission(void)
 
     G_FinishVote();
 
-    BuildDeathmatchScoreboard(game.oldscores, NULL);
+#if USE_SQLITE
+    G_StartRetention();
+#endif
+
+    BuildDeathmatchScoreboard(game.oldscores,
+                              va("yv 10 cstring2 \"Old scoreboard from %s\"",
+                                 level.mapname), NULL);
 
     // respawn any dead clients
     for (i = 0; i < game.maxclients; i++) {
@@ -410,7 +508,6 @@ void BeginIntermission(void)
 void G_PrivateString(edict_t *ent, int index, const char *string)
 {
     gclient_t *client;
-    int i;
 
     if (index < 0 || index >= PCS_TOTAL) {
         gi.error("%s: index %d out of range", __func__, index);
@@ -432,13 +529,8 @@ void G_PrivateString(edict_t *ent, int index, const char *string)
     if (ent->client->chase_target) {
         return;
     }
-    for (i = 0, client = game.clients; i < game.maxclients; i++, client++) {
-        if (client->pers.connected != CONN_SPECTATOR) {
-            continue;
-        }
-        if (client->chase_target == ent) {
-            G_PrivateString(client->edict, index, string);
-        }
+    LIST_FOR_EACH(gclient_t, client, &ent->client->level.chasers, level.chase_entry) {
+        G_PrivateString(client->edict, index, string);
     }
 }
 
@@ -462,6 +554,10 @@ returns 1 if the entity is visible to self, even if not infront ()
     VectorCopy(other->s.origin, spot2);
     spot2[2] += other->viewheight;
 
+    // don't bother tracing if eyes are in different areas
+    if (!gi.inPVS(spot1, spot2))
+        return qfalse;
+
     for (i = 0; i < 10; i++) {
         trace = gi.trace(spot1, vec3_origin, vec3_origin, spot2, self, mask);
 
@@ -487,6 +583,52 @@ returns 1 if the entity is visible to self, even if not infront ()
     return qfalse;
 }
 
+/*
+==============
+G_ResetVisibility
+
+Must be called each time level.framenum is reset.
+==============
+*/
+void G_ResetVisibility(void)
+{
+    memset(game.visibility, 0, game.maxclients * game.maxclients * sizeof(game.visibility[0]));
+}
+
+/*
+==============
+G_PlayersVisible
+
+Returns true if both players can see each other. Player ID view asks for
+the same pairs many times each frame, so results (including PVS rejects)
+are cached for g_viewid_frames frames.
+==============
+*/
+static qboolean G_PlayersVisible(edict_t *a, edict_t *b)
+{
+    visibility_t *v;
+    int i, j;
+
+    i = a - g_edicts - 1;
+    j = b - g_edicts - 1;
+    if (i > j) {
+        v = &game.visibility[j * game.maxclients + i];
+    } else {
+        v = &game.visibility[i * game.maxclients + j];
+    }
+
+    if (level.framenum < v->expires) {
+        return v->visible;
+    }
+
+    // note, we trace twice so we hit water planes
+    v->visible = visible(a, b, CONTENTS_SOLID | MASK_WATER) &&
+                 visible(b, a, CONTENTS_SOLID | MASK_WATER);
+    v->expires = level.framenum + max(g_viewid_frames->value, 1);
+
+    return v->visible;
+}
+
 /*
 ==============
 TDM_GetPlayerIdView
@@ -540,9 +682,8 @@ static edict_t *find_by_tracing(edict_t *ent)
             break;
 
         // we hit something that's a player and it's alive!
-        // note, we trace twice so we hit water planes
         if (tr.ent && tr.ent->client && tr.ent->health > 0 &&
-            visible(tr.ent, ent, CONTENTS_SOLID | MASK_WATER)) {
+            G_PlayersVisible(tr.ent, ent)) {
             return tr.ent;
         }
 
@@ -582,10 +723,7 @@ static edict_t *find_by_angles(edict_t *ent)
         VectorNormalize(dir);
         d = DotProduct(forward, dir);
 
-        // note, we trace twice so we hit water planes
-        if (d > bd &&
-            visible(ent, who, CONTENTS_SOLID | MASK_WATER) &&
-            visible(who, ent, CONTENTS_SOLID | MASK_WATER)) {
+        if (d > bd && G_PlayersVisible(ent, who)) {
             bdistance = distance;
             bd = d;
             best = who;
@@ -626,14 +764,45 @@ int G_GetPlayerIdView(edict_t *ent)
 
 /*
 ===============
-G_SetStats
+NextTimerFrame
+
+Returns frame number when displayed value of powerup
+timer expiring at given frame changes next.
 ===============
 */
-void G_SetStats(edict_t *ent)
+static int NextTimerFrame(int framenum, int next)
+{
+    int left = framenum - level.framenum;
+
+    if (left > 0) {
+        left /= HZ;
+        framenum -= left * HZ - (left ? 1 : 0);
+        if (framenum < next)
+            next = framenum;
+    }
+
+    return next;
+}
+
+/*
+===============
+G_CalcStats
+
+Stats that depend on rarely changing inputs are recomputed only if
+these inputs have changed since the last call, unless forced.
+===============
+*/
+static void G_CalcStats(edict_t *ent, qboolean force)
 {
     const gitem_t   *item;
-    int             index, cells;
+    int             index, cells, flash;
     int             power_armor_type;
+    qboolean        helpicon;
+
+    if (!ent->client->statcache.valid) {
+        ent->client->statcache.valid = qtrue;
+        force = qtrue;
+    }
 
     //
     // health
@@ -644,13 +813,19 @@ void G_SetStats(edict_t *ent)
     //
     // ammo
     //
-    if (!ent->client->ammo_index /* || !ent->client->pers.inventory[ent->client->ammo_index] */) {
-        ent->client->ps.stats[STAT_AMMO_ICON] = 0;
-        ent->client->ps.stats[STAT_AMMO] = 0;
-    } else {
-        item = INDEX_ITEM(ent->client->ammo_index);
-        ent->client->ps.stats[STAT_AMMO_ICON] = gi.imageindex(item->icon);
-        ent->client->ps.stats[STAT_AMMO] = ent->client->inventory[ent->client->ammo_index];
+    index = ent->client->ammo_index;
+    if (force || ent->client->statcache.ammo_index != index ||
+        (index && ent->client->statcache.ammo != ent->client->inventory[index])) {
+        if (!index /* || !ent->client->pers.inventory[index] */) {
+            ent->client->ps.stats[STAT_AMMO_ICON] = 0;
+            ent->client->ps.stats[STAT_AMMO] = 0;
+        } else {
+            item = INDEX_ITEM(index);
+            ent->client->ps.stats[STAT_AMMO_ICON] = G_ItemIcon(item);
+            ent->client->ps.stats[STAT_AMMO] = ent->client->inventory[index];
+            ent->client->statcache.ammo = ent->client->inventory[index];
+        }
+        ent->client->statcache.ammo_index = index;
     }
 
     //
@@ -669,21 +844,33 @@ void G_SetStats(edict_t *ent)
     }
 
     index = ArmorIndex(ent);
-    if (power_armor_type && (!index || ((level.framenum / FRAMEDIV) & 8))) {
-        // flash between power armor and other armor icon
-        // Knightmare- use correct icon for power screen
-        if (power_armor_type == ITEM_POWER_SHIELD)
-            ent->client->ps.stats[STAT_ARMOR_ICON] = level.images.powershield;
-        else	// POWER_ARMOR_SCREEN
-            ent->client->ps.stats[STAT_ARMOR_ICON] = level.images.powerscreen;
-        ent->client->ps.stats[STAT_ARMOR] = cells;
-    } else if (index) {
-        item = INDEX_ITEM(index);
-        ent->client->ps.stats[STAT_ARMOR_ICON] = gi.imageindex(item->icon);
-        ent->client->ps.stats[STAT_ARMOR] = ent->client->inventory[index];
-    } else {
-        ent->client->ps.stats[STAT_ARMOR_ICON] = 0;
-        ent->client->ps.stats[STAT_ARMOR] = 0;
+    flash = power_armor_type && (!index || ((level.framenum / FRAMEDIV) & 8));
+    if (force || ent->client->statcache.power_armor != power_armor_type ||
+        ent->client->statcache.cells != cells ||
+        ent->client->statcache.armor_index != index ||
+        ent->client->statcache.armor != ent->client->inventory[index] ||
+        ent->client->statcache.armor_flash != flash) {
+        if (flash) {
+            // flash between power armor and other armor icon
+            // Knightmare- use correct icon for power screen
+            if (power_armor_type == ITEM_POWER_SHIELD)
+                ent->client->ps.stats[STAT_ARMOR_ICON] = level.images.powershield;
+            else	// POWER_ARMOR_SCREEN
+                ent->client->ps.stats[STAT_ARMOR_ICON] = level.images.powerscreen;
+            ent->client->ps.stats[STAT_ARMOR] = cells;
+        } else if (index) {
+            item = INDEX_ITEM(index);
+            ent->client->ps.stats[STAT_ARMOR_ICON] = G_ItemIcon(item);
+            ent->client->ps.stats[STAT_ARMOR] = ent->client->inventory[index];
+        } else {
+            ent->client->ps.stats[STAT_ARMOR_ICON] = 0;
+            ent->client->ps.stats[STAT_ARMOR] = 0;
+        }
+        ent->client->statcache.power_armor = power_armor_type;
+        ent->client->statcache.cells = cells;
+        ent->client->statcache.armor_index = index;
+        ent->client->statcache.armor = ent->client->inventory[index];
+        ent->client->statcache.armor_flash = flash;
     }
 
     //
@@ -695,59 +882,93 @@ void G_SetStats(edict_t *ent)
     }
 
     //
-    // timer 1 (quad, enviro, breather)
+    // timers only change when a powerup is picked up
+    // or when displayed number of seconds changes
     //
-    if (ent->client->quad_framenum > level.framenum) {
-        ent->client->ps.stats[STAT_TIMER_ICON] = level.images.quad;
-        ent->client->ps.stats[STAT_TIMER] = (ent->client->quad_framenum - level.framenum) / HZ;
-    }
+    if (force || level.framenum >= ent->client->statcache.timer_framenum ||
+        ent->client->statcache.quad != ent->client->quad_framenum ||
 #ifdef XATRIX
-    // RAFAEL
-    else if (ent->client->quadfire_framenum > level.framenum)
-    {
-        // note to self
-        // need to change imageindex
-        ent->client->ps.stats[STAT_TIMER_ICON] = level.images.quadfire;
-        ent->client->ps.stats[STAT_TIMER] = (ent->client->quadfire_framenum - level.framenum) / HZ;
-    }
+        ent->client->statcache.quadfire != ent->client->quadfire_framenum ||
 #endif //XATRIX
-    else if (ent->client->enviro_framenum > level.framenum) {
-        ent->client->ps.stats[STAT_TIMER_ICON] = level.images.envirosuit;
-        ent->client->ps.stats[STAT_TIMER] = (ent->client->enviro_framenum - level.framenum) / HZ;
-    } else if (ent->client->breather_framenum > level.framenum) {
-        ent->client->ps.stats[STAT_TIMER_ICON] = level.images.rebreather;
-        ent->client->ps.stats[STAT_TIMER] = (ent->client->breather_framenum - level.framenum) / HZ;
-    } else {
-        ent->client->ps.stats[STAT_TIMER_ICON] = 0;
-        ent->client->ps.stats[STAT_TIMER] = 0;
-    }
-
-    //
-    // timer 2 (pent)
-    //
-    ent->client->ps.stats[STAT_TIMER2_ICON] = 0;
-    ent->client->ps.stats[STAT_TIMER2] = 0;
-    if (ent->client->invincible_framenum > level.framenum) {
-        if (ent->client->ps.stats[STAT_TIMER_ICON]) {
-            ent->client->ps.stats[STAT_TIMER2_ICON] = level.images.invulnerability;
-            ent->client->ps.stats[STAT_TIMER2] = (ent->client->invincible_framenum - level.framenum) / HZ;
+        ent->client->statcache.enviro != ent->client->enviro_framenum ||
+        ent->client->statcache.breather != ent->client->breather_framenum ||
+        ent->client->statcache.invincible != ent->client->invincible_framenum) {
+
+        //
+        // timer 1 (quad, enviro, breather)
+        //
+        if (ent->client->quad_framenum > level.framenum) {
+            ent->client->ps.stats[STAT_TIMER_ICON] = level.images.quad;
+            ent->client->ps.stats[STAT_TIMER] = (ent->client->quad_framenum - level.framenum) / HZ;
+        }
+#ifdef XATRIX
+        // RAFAEL
+        else if (ent->client->quadfire_framenum > level.framenum)
+        {
+            // note to self
+            // need to change imageindex
+            ent->client->ps.stats[STAT_TIMER_ICON] = level.images.quadfire;
+            ent->client->ps.stats[STAT_TIMER] = (ent->client->quadfire_framenum - level.framenum) / HZ;
+        }
+#endif //XATRIX
+        else if (ent->client->enviro_framenum > level.framenum) {
+            ent->client->ps.stats[STAT_TIMER_ICON] = level.images.envirosuit;
+            ent->client->ps.stats[STAT_TIMER] = (ent->client->enviro_framenum - level.framenum) / HZ;
+        } else if (ent->client->breather_framenum > level.framenum) {
+            ent->client->ps.stats[STAT_TIMER_ICON] = level.images.rebreather;
+            ent->client->ps.stats[STAT_TIMER] = (ent->client->breather_framenum - level.framenum) / HZ;
         } else {
-            ent->client->ps.stats[STAT_TIMER_ICON] = level.images.invulnerability;
-            ent->client->ps.stats[STAT_TIMER] = (ent->client->invincible_framenum - level.framenum) / HZ;
+            ent->client->ps.stats[STAT_TIMER_ICON] = 0;
+            ent->client->ps.stats[STAT_TIMER] = 0;
         }
+
+        //
+        // timer 2 (pent)
+        //
+        ent->client->ps.stats[STAT_TIMER2_ICON] = 0;
+        ent->client->ps.stats[STAT_TIMER2] = 0;
+        if (ent->client->invincible_framenum > level.framenum) {
+            if (ent->client->ps.stats[STAT_TIMER_ICON]) {
+                ent->client->ps.stats[STAT_TIMER2_ICON] = level.images.invulnerability;
+                ent->client->ps.stats[STAT_TIMER2] = (ent->client->invincible_framenum - level.framenum) / HZ;
+            } else {
+                ent->client->ps.stats[STAT_TIMER_ICON] = level.images.invulnerability;
+                ent->client->ps.stats[STAT_TIMER] = (ent->client->invincible_framenum - level.framenum) / HZ;
+            }
+        }
+
+        ent->client->statcache.quad = ent->client->quad_framenum;
+#ifdef XATRIX
+        ent->client->statcache.quadfire = ent->client->quadfire_framenum;
+        index = NextTimerFrame(ent->client->quadfire_framenum, INT_MAX);
+#else
+        index = INT_MAX;
+#endif //XATRIX
+        ent->client->statcache.enviro = ent->client->enviro_framenum;
+        ent->client->statcache.breather = ent->client->breather_framenum;
+        ent->client->statcache.invincible = ent->client->invincible_framenum;
+
+        index = NextTimerFrame(ent->client->quad_framenum, index);
+        index = NextTimerFrame(ent->client->enviro_framenum, index);
+        index = NextTimerFrame(ent->client->breather_framenum, index);
+        index = NextTimerFrame(ent->client->invincible_framenum, index);
+        ent->client->statcache.timer_framenum = index;
     }
 
     //
     // selected item
     //
-    if (ent->client->selected_item == -1) {
-        ent->client->ps.stats[STAT_SELECTED_ICON] = 0;
-    } else {
-        item = INDEX_ITEM(ent->client->selected_item);
-        ent->client->ps.stats[STAT_SELECTED_ICON] = gi.imageindex(item->icon);
-    }
+    if (force || ent->client->statcache.selected_item != ent->client->selected_item) {
+        if (ent->client->selected_item == -1) {
+            ent->client->ps.stats[STAT_SELECTED_ICON] = 0;
+        } else {
+            item = INDEX_ITEM(ent->client->selected_item);
+            ent->client->ps.stats[STAT_SELECTED_ICON] = G_ItemIcon(item);
+        }
 
-    ent->client->ps.stats[STAT_SELECTED_ITEM] = ent->client->selected_item;
+        ent->client->ps.stats[STAT_SELECTED_ITEM] = ent->client->selected_item;
+        ent->client->statcache.selected_item = ent->client->selected_item;
+    }
 
     //
     // layouts
@@ -765,10 +986,16 @@ void G_SetStats(edict_t *ent)
     //
     // help icon / current weapon if not shown
     //
-    if ((ent->client->pers.hand == CENTER_HANDED || ent->client->ps.fov > 91) && ent->client->weapon)
-        ent->client->ps.stats[STAT_HELPICON] = gi.imageindex(ent->client->weapon->icon);
-    else
-        ent->client->ps.stats[STAT_HELPICON] = 0;
+    helpicon = (ent->client->pers.hand == CENTER_HANDED || ent->client->ps.fov > 91) && ent->client->weapon;
+    if (force || ent->client->statcache.helpicon != helpicon ||
+        ent->client->statcache.weapon != ent->client->weapon) {
+        if (helpicon)
+            ent->client->ps.stats[STAT_HELPICON] = G_ItemIcon(ent->client->weapon);
+        else
+            ent->client->ps.stats[STAT_HELPICON] = 0;
+        ent->client->statcache.helpicon = helpicon;
+        ent->client->statcache.weapon = ent->client->weapon;
+    }
 
     ent->client->ps.stats[STAT_SPECTATOR] = 0;
     ent->client->ps.stats[STAT_CHASE] = 0;
@@ -815,3 +1042,33 @@ void G_SetStats(edict_t *ent)
     }
 }
 
+/*
+===============
+G_SetStats
+
+With g_debug_stats enabled, also does full recompute and
+reports stats that incremental update got wrong.
+===============
+*/
+void G_SetStats(edict_t *ent)
+{
+    short   stats[MAX_STATS];
+    int     i;
+
+    G_CalcStats(ent, qfalse);
+
+    if (!g_debug_stats->value) {
+        return;
+    }
+
+    memcpy(stats, ent->client->ps.stats, sizeof(stats));
+    G_CalcStats(ent, qtrue);
+
+    for (i = 0; i < MAX_STATS; i++) {
+        if (stats[i] != ent->client->ps.stats[i]) {
+            gi.dprintf("%s: %s stat %d is %d, should be %d\n", __func__,
+                       ent->client->pers.netname, i, stats[i], ent->client->ps.stats[i]);
+        }
+    }
+}
+
@@ -19,22 +19,43 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 #include "g_local.h"
 
-static void PMenu_Write(edict_t *ent)
+#define MAX_MENU_LAYOUTS    8
+
+// menu layout rendered without cursor, shared by all clients that
+// view the same entries
+typedef struct pmenu_layout_s {
+    const char      *text[MAX_MENU_ENTRIES];
+    pmenu_align_t   align[MAX_MENU_ENTRIES];
+    short           offsets[MAX_MENU_ENTRIES];  // of 'string' suffix, -1 if not rendered
+    size_t          length;
+    char            string[MAX_STRING_CHARS];
+} pmenu_layout_t;
+
+static pmenu_layout_t   pmenu_layouts[MAX_MENU_LAYOUTS];
+static int              pmenu_numlayouts;   // total number rendered
+
+/*
+Entries are rendered one character to the left with a blank in place of
+the cursor, so that highlighting an entry only changes two characters:
+'string' suffix and the blank.
+*/
+static void PMenu_Render(pmenu_layout_t *l, const pmenu_t *menu)
 {
-    char string[MAX_STRING_CHARS];
     char entry[MAX_STRING_CHARS];
     int i;
-    size_t total, len;
-    pmenu_entry_t *p;
+    size_t total, len, suffix;
+    const pmenu_entry_t *p;
     int x;
-    pmenu_t *menu = &ent->client->menu;
     const char *t;
     qboolean alt;
 
-    strcpy(string, "xv 32 yv 8 picn inventory ");
-    total = strlen(string);
+    strcpy(l->string, "xv 32 yv 8 picn inventory ");
+    total = strlen(l->string);
 
     for (i = 0, p = menu->entries; i < MAX_MENU_ENTRIES; i++, p++) {
+        l->text[i] = p->text;
+        l->align[i] = p->align;
+        l->offsets[i] = -1;
         if (!p->text || !p->text[0])
             continue; // blank line
         t = p->text;
@@ -51,26 +72,83 @@ static void PMenu_Write(edict_t *ent)
         else
             x = 64;
 
-        if (menu->cur == i) {
-            x -= 8;
-            alt ^= 1;
-        }
-
-        len = Q_snprintf(entry, sizeof(entry), "yv %d xv %d string%s \"%s%s\" ",
-                         32 + i * 8, x, alt ? "2" : "", menu->cur == i ? "\x0d" : "", t);
+        suffix = Q_snprintf(entry, sizeof(entry), "yv %d xv %d string", 32 + i * 8, x - 8);
+        len = suffix + Q_snprintf(entry + suffix, sizeof(entry) - suffix,
+                                  "%c \" %s\" ", alt ? '2' : ' ', t);
         if (len >= sizeof(entry)) {
             continue;
         }
         if (total + len >= MAX_STRING_CHARS)
             break;
-        memcpy(string + total, entry, len);
+        memcpy(l->string + total, entry, len);
+        l->offsets[i] = total + suffix;
         total += len;
     }
 
-    string[total] = 0;
+    l->string[total] = 0;
+    l->length = total;
+}
+
+static qboolean PMenu_LayoutMatches(const pmenu_layout_t *l, const pmenu_t *menu)
+{
+    int i;
+
+    for (i = 0; i < MAX_MENU_ENTRIES; i++) {
+        if (l->text[i] != menu->entries[i].text)
+            return qfalse;
+        if (l->align[i] != menu->entries[i].align)
+            return qfalse;
+    }
+
+    return qtrue;
+}
+
+static pmenu_layout_t *PMenu_FindLayout(pmenu_t *menu)
+{
+    pmenu_layout_t *l;
+    int i, count;
+
+    if (menu->layout && PMenu_LayoutMatches(menu->layout, menu)) {
+        return menu->layout;
+    }
+
+    count = min(pmenu_numlayouts, MAX_MENU_LAYOUTS);
+    for (i = 0, l = pmenu_layouts; i < count; i++, l++) {
+        if (PMenu_LayoutMatches(l, menu)) {
+            menu->layout = l;
+            return l;
+        }
+    }
+
+    // replace the oldest one
+    l = &pmenu_layouts[pmenu_numlayouts++ % MAX_MENU_LAYOUTS];
+    PMenu_Render(l, menu);
+    menu->layout = l;
+    return l;
+}
+
+static void PMenu_Write(edict_t *ent)
+{
+    pmenu_t *menu = &ent->client->menu;
+    pmenu_layout_t *l = PMenu_FindLayout(menu);
+    char *s = NULL;
+
+    // temporarily highlight current entry
+    if (menu->cur >= 0 && menu->cur < MAX_MENU_ENTRIES && l->offsets[menu->cur] >= 0) {
+        s = l->string + l->offsets[menu->cur];
+        s[0] = s[0] == '2' ? ' ' : '2';
+        s[3] = '\x0d';
+    }
+
+    ent->client->level.scoreboard = 0;
 
     gi.WriteByte(svc_layout);
-    gi.WriteString(string);
+    gi.WriteString(l->string);
+
+    if (s) {
+        s[0] = s[0] == '2' ? ' ' : '2';
+        s[3] = ' ';
+    }
 }
 
 void PMenu_Open(edict_t *ent, const pmenu_entry_t *entries)
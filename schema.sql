@@ -118,4 +118,63 @@ CREATE TABLE items(
 
 CREATE INDEX items_idx ON items(player_id,clock);
 
+-- daily roll-ups of the tables above, filled in when g_sql_retention is set
+-- and raw rows older than that many days are deleted
+-- day is UNIX time divided by 86400
+CREATE TABLE records_daily(
+    player_id INT,  -- REFERENCES players(rowid)
+    day INT,
+    sessions INT,   -- number of records rows folded in
+    time INT,
+    score INT,
+    deaths INT,
+    damage_given INT,
+    damage_recvd INT,
+    PRIMARY KEY(player_id,day)
+);
+
+CREATE TABLE frags_daily(
+    player_id INT,  -- REFERENCES players(rowid)
+    day INT,
+    frag INT,
+    kills INT,
+    deaths INT,
+    suicides INT,
+    atts INT,
+    hits INT,
+    PRIMARY KEY(player_id,day,frag)
+);
+
+CREATE TABLE items_daily(
+    player_id INT,  -- REFERENCES players(rowid)
+    day INT,
+    item INT,
+    pickups INT,
+    misses INT,
+    kills INT,
+    PRIMARY KEY(player_id,day,item)
+);
+
+-- lifetime totals, updated on every insert into records and frags
+CREATE TABLE player_totals(
+    player_id INTEGER PRIMARY KEY,  -- REFERENCES players(rowid)
+    sessions INT,   -- number of records rows
+    time INT,
+    score INT,
+    deaths INT,
+    damage_given INT,
+    damage_recvd INT
+);
+
+CREATE TABLE frag_totals(
+    player_id INT,  -- REFERENCES players(rowid)
+    frag INT,
+    kills INT,
+    deaths INT,
+    suicides INT,
+    atts INT,
+    hits INT,
+    PRIMARY KEY(player_id,frag)
+);
+
 COMMIT;